@@ -0,0 +1,253 @@
+#include "link_baud.h"
+#include <string.h>
+
+static const uint32_t link_rates[LINK_BAUD_NUM_RATES] = LINK_BAUD_RATES;
+
+/* Wrap-safe "now is at or past deadline" */
+static bool time_reached(uint32_t now_ms, uint32_t deadline_ms) {
+    return (int32_t)(now_ms - deadline_ms) >= 0;
+}
+
+static uint32_t rx_errors(const link_rx_stats_t *stats) {
+    return stats->crc_errors + stats->resyncs;
+}
+
+static bool rate_supported(uint32_t baud) {
+    if (baud == LINK_BAUD_BASE) {
+        return true;
+    }
+    for (int i = 0; i < LINK_BAUD_NUM_RATES; i++) {
+        if (link_rates[i] == baud) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Probe payload: id byte followed by alternating bits, runs of ones and
+ * zero bytes (which exercise COBS stuffing) */
+static void probe_payload(uint8_t id, uint8_t *out) {
+    static const uint8_t pattern[LINK_BAUD_PROBE_SIZE - 1] = {
+        0x55, 0xAA, 0x00, 0xFF, 0x01, 0x80, 0x7F, 0xFE,
+        0x33, 0xCC, 0x0F, 0xF0, 0x00, 0x5A, 0xA5
+    };
+    out[0] = id;
+    memcpy(&out[1], pattern, sizeof(pattern));
+}
+
+static void send_ping(link_baud_master_t *master, uint32_t now_ms, uint32_t timeout_ms) {
+    uint8_t payload[LINK_BAUD_PROBE_SIZE];
+    master->ping_id++;
+    probe_payload(master->ping_id, payload);
+    master->ops.send(master->ops.ctx, LINK_TYPE_PING, payload, sizeof(payload));
+    master->ping_outstanding = true;
+    master->deadline_ms = now_ms + timeout_ms;
+}
+
+/* Return to the base rate and try rate_index after the slave has reverted too */
+static void master_settle(link_baud_master_t *master, uint32_t now_ms, uint8_t rate_index) {
+    if (master->baud != LINK_BAUD_BASE) {
+        master->ops.set_baud(master->ops.ctx, LINK_BAUD_BASE);
+        master->baud = LINK_BAUD_BASE;
+    }
+    master->rate_index = rate_index;
+    master->ping_outstanding = false;
+    master->state = LINK_BAUD_SETTLE;
+    master->deadline_ms = now_ms + LINK_BAUD_SETTLE_MS;
+}
+
+void link_baud_master_init(link_baud_master_t *master, const link_baud_ops_t *ops, uint32_t now_ms) {
+    memset(master, 0, sizeof(*master));
+    master->ops = *ops;
+    master->baud = LINK_BAUD_BASE;
+    master->ack_timeout_ms = LINK_BAUD_ACK_TIMEOUT_MS;
+    master->probe_timeout_ms = LINK_BAUD_PROBE_TIMEOUT_MS;
+    master->retry_ms = LINK_BAUD_RETRY_MS;
+    master->ops.set_baud(master->ops.ctx, LINK_BAUD_BASE);
+
+    /* The slave may still be at a high rate from before our reset */
+    master_settle(master, now_ms, 0);
+}
+
+void link_baud_master_set_timeouts(link_baud_master_t *master, uint32_t ack_timeout_ms,
+                                   uint32_t probe_timeout_ms) {
+    master->ack_timeout_ms = ack_timeout_ms;
+    master->probe_timeout_ms = probe_timeout_ms;
+}
+
+void link_baud_master_poll(link_baud_master_t *master, uint32_t now_ms,
+                           const link_rx_stats_t *rx_stats) {
+    switch (master->state) {
+        case LINK_BAUD_SETTLE:
+            if (!time_reached(now_ms, master->deadline_ms)) {
+                break;
+            }
+            if (master->rate_index >= LINK_BAUD_NUM_RATES) {
+                /* Nothing faster passed; run at the base rate for now */
+                master->state = LINK_BAUD_RUNNING;
+                master->deadline_ms = now_ms + master->retry_ms;
+                master->retry_ms *= 2;
+                if (master->retry_ms > LINK_BAUD_RETRY_MAX_MS) {
+                    master->retry_ms = LINK_BAUD_RETRY_MAX_MS;
+                }
+                break;
+            }
+            {
+                uint8_t payload[4];
+                link_put_u32(payload, link_rates[master->rate_index]);
+                master->ops.send(master->ops.ctx, LINK_TYPE_BAUD, payload, sizeof(payload));
+            }
+            master->state = LINK_BAUD_WAIT_ACK;
+            master->deadline_ms = now_ms + master->ack_timeout_ms;
+            break;
+
+        case LINK_BAUD_WAIT_ACK:
+            if (time_reached(now_ms, master->deadline_ms)) {
+                /* No answer (old firmware, or the request was lost) */
+                master_settle(master, now_ms, master->rate_index + 1);
+            }
+            break;
+
+        case LINK_BAUD_PROBING:
+            if (master->ping_outstanding) {
+                if (!time_reached(now_ms, master->deadline_ms)) {
+                    break;
+                }
+                master->ping_outstanding = false;  /* Lost */
+            }
+            if (master->probes_sent < LINK_BAUD_PROBES) {
+                if (time_reached(now_ms, master->deadline_ms)) {
+                    send_ping(master, now_ms, master->probe_timeout_ms);
+                    master->probes_sent++;
+                }
+            } else if (master->probes_ok == LINK_BAUD_PROBES) {
+                master->state = LINK_BAUD_RUNNING;
+                master->retry_ms = LINK_BAUD_RETRY_MS;
+                master->missed_pings = 0;
+                master->deadline_ms = now_ms + LINK_BAUD_KEEPALIVE_MS;
+                master->error_count = rx_errors(rx_stats);
+                master->window_start_ms = now_ms;
+            } else {
+                master_settle(master, now_ms, master->rate_index + 1);
+            }
+            break;
+
+        case LINK_BAUD_RUNNING:
+            if (master->baud == LINK_BAUD_BASE) {
+                if (time_reached(now_ms, master->deadline_ms)) {
+                    master_settle(master, now_ms, 0);
+                }
+                break;
+            }
+            if (time_reached(now_ms, master->window_start_ms + LINK_BAUD_ERROR_WINDOW_MS)) {
+                uint32_t errors = rx_errors(rx_stats);
+                if (errors - master->error_count >= LINK_BAUD_MAX_ERRORS) {
+                    master_settle(master, now_ms, master->rate_index + 1);
+                    break;
+                }
+                master->error_count = errors;
+                master->window_start_ms = now_ms;
+            }
+            if (time_reached(now_ms, master->deadline_ms)) {
+                if (master->ping_outstanding && ++master->missed_pings >= LINK_BAUD_MAX_MISSES) {
+                    master_settle(master, now_ms, 0);
+                    break;
+                }
+                send_ping(master, now_ms, LINK_BAUD_KEEPALIVE_MS);
+            }
+            break;
+    }
+}
+
+bool link_baud_master_handle_frame(link_baud_master_t *master, const link_frame_t *frame,
+                                   uint32_t now_ms) {
+    switch (frame->type) {
+        case LINK_TYPE_BAUD:
+            if (master->state == LINK_BAUD_WAIT_ACK && frame->len == 4 &&
+                link_get_u32(frame->payload) == link_rates[master->rate_index]) {
+                master->baud = link_rates[master->rate_index];
+                master->ops.set_baud(master->ops.ctx, master->baud);
+                master->state = LINK_BAUD_PROBING;
+                master->probes_sent = 0;
+                master->probes_ok = 0;
+                master->ping_outstanding = false;
+                master->deadline_ms = now_ms + LINK_BAUD_SWITCH_DELAY_MS;
+            }
+            return true;
+
+        case LINK_TYPE_PONG: {
+            uint8_t expected[LINK_BAUD_PROBE_SIZE];
+            probe_payload(master->ping_id, expected);
+            if (!master->ping_outstanding || frame->len != LINK_BAUD_PROBE_SIZE ||
+                memcmp(frame->payload, expected, sizeof(expected)) != 0) {
+                return true;
+            }
+            master->ping_outstanding = false;
+            if (master->state == LINK_BAUD_PROBING) {
+                master->probes_ok++;
+                master->deadline_ms = now_ms;  /* Next probe right away */
+            } else {
+                master->missed_pings = 0;
+            }
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+static void slave_revert(link_baud_slave_t *slave, uint32_t now_ms) {
+    slave->ops.set_baud(slave->ops.ctx, LINK_BAUD_BASE);
+    slave->baud = LINK_BAUD_BASE;
+    slave->last_rx_ms = now_ms;
+}
+
+void link_baud_slave_init(link_baud_slave_t *slave, const link_baud_ops_t *ops, uint32_t now_ms) {
+    memset(slave, 0, sizeof(*slave));
+    slave->ops = *ops;
+    slave->window_start_ms = now_ms;
+    slave_revert(slave, now_ms);
+}
+
+void link_baud_slave_poll(link_baud_slave_t *slave, uint32_t now_ms,
+                          const link_rx_stats_t *rx_stats) {
+    if (time_reached(now_ms, slave->window_start_ms + LINK_BAUD_ERROR_WINDOW_MS)) {
+        uint32_t errors = rx_errors(rx_stats);
+        bool burst = errors - slave->error_count >= LINK_BAUD_MAX_ERRORS;
+        slave->error_count = errors;
+        slave->window_start_ms = now_ms;
+        if (burst && slave->baud != LINK_BAUD_BASE) {
+            slave_revert(slave, now_ms);
+            return;
+        }
+    }
+
+    if (slave->baud != LINK_BAUD_BASE &&
+        time_reached(now_ms, slave->last_rx_ms + LINK_BAUD_SILENCE_MS)) {
+        slave_revert(slave, now_ms);
+    }
+}
+
+bool link_baud_slave_handle_frame(link_baud_slave_t *slave, const link_frame_t *frame,
+                                  uint32_t now_ms) {
+    slave->last_rx_ms = now_ms;
+
+    switch (frame->type) {
+        case LINK_TYPE_BAUD:
+            if (frame->len == 4 && rate_supported(link_get_u32(frame->payload))) {
+                /* Accept at the current rate, then follow the master */
+                slave->ops.send(slave->ops.ctx, LINK_TYPE_BAUD, frame->payload, frame->len);
+                slave->baud = link_get_u32(frame->payload);
+                slave->ops.set_baud(slave->ops.ctx, slave->baud);
+            }
+            return true;
+
+        case LINK_TYPE_PING:
+            slave->ops.send(slave->ops.ctx, LINK_TYPE_PONG, frame->payload, frame->len);
+            return true;
+
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef LINK_BAUD_H
+#define LINK_BAUD_H
+
+/*
+ * Link baud-rate negotiation
+ *
+ * Both ends power up at LINK_BAUD_BASE. The sending side (master: the
+ * uart-bridge Pico, or controller_bridge itself on a USB-UART adapter) then
+ * walks down LINK_BAUD_RATES:
+ *
+ *   1. At the base rate, send LINK_TYPE_BAUD <rate>. The receiving side
+ *      (slave: the Switch Pico) echoes it, drains its TX and switches.
+ *   2. The master switches and sends LINK_BAUD_PROBES pings with a mixed
+ *      bit pattern. Every one must come back as an intact PONG.
+ *   3. If any probe is lost the master returns to the base rate, waits for
+ *      the slave to time out as well and tries the next lower rate.
+ *   4. If no rate passed, the master runs at the base rate and starts over
+ *      after LINK_BAUD_RETRY_MS, doubling the wait each time up to
+ *      LINK_BAUD_RETRY_MAX_MS. The slave may simply not have been up yet
+ *      (the Switch Pico starts its link core ~2 s after power-up).
+ *
+ * While running above the base rate the master pings every
+ * LINK_BAUD_KEEPALIVE_MS. Either side drops back to the base rate when
+ * receive errors rise or the link goes quiet: the slave after
+ * LINK_BAUD_SILENCE_MS without a valid frame, the master after
+ * LINK_BAUD_MAX_MISSES unanswered pings. The master then renegotiates,
+ * one rate lower after an error burst, from the top after a silence (the
+ * slave most likely restarted).
+ *
+ * Platform code supplies the UART and frame I/O through link_baud_ops_t;
+ * time is passed in as a free-running millisecond counter.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "link_protocol.h"
+
+#define LINK_BAUD_BASE 115200
+
+/* Candidate rates, fastest first */
+#define LINK_BAUD_RATES { 3000000, 1500000, 921600 }
+#define LINK_BAUD_NUM_RATES 3
+
+#define LINK_BAUD_PROBES            8
+#define LINK_BAUD_PROBE_SIZE        16
+#define LINK_BAUD_ACK_TIMEOUT_MS    50
+#define LINK_BAUD_PROBE_TIMEOUT_MS  20
+#define LINK_BAUD_SWITCH_DELAY_MS   2    /* Let the slave finish switching */
+#define LINK_BAUD_KEEPALIVE_MS      50
+#define LINK_BAUD_MAX_MISSES        3
+#define LINK_BAUD_SILENCE_MS        250
+#define LINK_BAUD_SETTLE_MS         (LINK_BAUD_SILENCE_MS + 50)
+#define LINK_BAUD_ERROR_WINDOW_MS   100
+#define LINK_BAUD_MAX_ERRORS        8    /* CRC errors + resyncs per window */
+#define LINK_BAUD_RETRY_MS          1000
+#define LINK_BAUD_RETRY_MAX_MS      32000
+
+typedef struct {
+    /* Reprogram the UART; must wait for pending TX to drain first */
+    void (*set_baud)(void *ctx, uint32_t baud);
+    /* Encode and transmit one frame */
+    void (*send)(void *ctx, uint8_t type, const uint8_t *payload, size_t len);
+    void *ctx;
+} link_baud_ops_t;
+
+typedef enum {
+    LINK_BAUD_SETTLE,      /* At base rate, waiting for the slave to revert */
+    LINK_BAUD_WAIT_ACK,    /* Switch requested, waiting for the echo */
+    LINK_BAUD_PROBING,     /* Switched, checking the new rate */
+    LINK_BAUD_RUNNING
+} link_baud_state_t;
+
+typedef struct {
+    link_baud_ops_t ops;
+    link_baud_state_t state;
+    uint32_t baud;
+    uint8_t rate_index;        /* Rate being tried or used; NUM_RATES = base */
+    uint32_t deadline_ms;
+    uint8_t probes_sent;
+    uint8_t probes_ok;
+    bool ping_outstanding;
+    uint8_t ping_id;
+    uint8_t missed_pings;
+    uint32_t error_count;      /* Receive errors at the start of the window */
+    uint32_t window_start_ms;
+    uint32_t ack_timeout_ms;   /* LINK_BAUD_ACK_TIMEOUT_MS unless set */
+    uint32_t probe_timeout_ms; /* LINK_BAUD_PROBE_TIMEOUT_MS unless set */
+    uint32_t retry_ms;         /* Wait at the base rate before the next attempt */
+} link_baud_master_t;
+
+typedef struct {
+    link_baud_ops_t ops;
+    uint32_t baud;
+    uint32_t last_rx_ms;
+    uint32_t error_count;
+    uint32_t window_start_ms;
+} link_baud_slave_t;
+
+void link_baud_master_init(link_baud_master_t *master, const link_baud_ops_t *ops, uint32_t now_ms);
+
+/* For a master whose replies take longer than a Pico's, e.g. behind a
+ * USB-UART adapter. Keep both well under LINK_BAUD_SILENCE_MS. */
+void link_baud_master_set_timeouts(link_baud_master_t *master, uint32_t ack_timeout_ms,
+                                   uint32_t probe_timeout_ms);
+
+/* Advance timeouts and keepalives; rx_stats are the master's decoder counters */
+void link_baud_master_poll(link_baud_master_t *master, uint32_t now_ms,
+                           const link_rx_stats_t *rx_stats);
+
+/* Returns true if the frame was part of the negotiation */
+bool link_baud_master_handle_frame(link_baud_master_t *master, const link_frame_t *frame,
+                                   uint32_t now_ms);
+
+void link_baud_slave_init(link_baud_slave_t *slave, const link_baud_ops_t *ops, uint32_t now_ms);
+
+void link_baud_slave_poll(link_baud_slave_t *slave, uint32_t now_ms,
+                          const link_rx_stats_t *rx_stats);
+
+/* Call for every valid frame; returns true if it was part of the negotiation */
+bool link_baud_slave_handle_frame(link_baud_slave_t *slave, const link_frame_t *frame,
+                                  uint32_t now_ms);
+
+#endif /* LINK_BAUD_H */
@@ -0,0 +1,74 @@
+#ifndef LINK_MACRO_H
+#define LINK_MACRO_H
+
+/*
+ * Macro bytecode and image format
+ *
+ * Macros run on the Switch Pico, one step per HID report, so combos and
+ * autofire keep report-exact timing without using the link. The PC uploads
+ * an image of up to LINK_MACRO_SLOTS macros, which the Switch Pico keeps in
+ * the last flash sector, and starts one with LINK_CMD_MACRO_RUN <slot>.
+ *
+ * Image layout (little endian):
+ *
+ *   [0..3]   LINK_MACRO_MAGIC
+ *   [4..5]   total image length, header included
+ *   [6..7]   CRC-16 (link_crc16) of bytes LINK_MACRO_HEADER_SIZE..length-1
+ *   [8..]    LINK_MACRO_SLOTS uint16 offsets of each macro's first
+ *            instruction, LINK_MACRO_NO_SLOT if unused
+ *   [..]     bytecode
+ *
+ * Instructions (operands little endian):
+ *
+ *   END                      stop (buttons pressed by the macro released)
+ *   PRESS   <mask16>         press buttons
+ *   RELEASE <mask16>         release buttons
+ *   HOLD    <n8>             keep the current state for n reports
+ *   WAIT    <ms16>           keep the current state for ms milliseconds
+ *   LOOP    <count8>         repeat up to the matching NEXT count times
+ *                            (0 = forever); nests LINK_MACRO_MAX_DEPTH deep
+ *   NEXT                     end of a LOOP body
+ *   TURBO   <mask16> <n8>    toggle autofire for buttons: while held (by the
+ *                            macro or the PC) they alternate pressed and
+ *                            released every n reports. Outlives the macro
+ *                            until toggled off or LINK_CMD_MACRO_STOP.
+ */
+
+#include <stdint.h>
+
+#define LINK_MACRO_MAGIC       0x4D523253u  /* "S2RM" */
+#define LINK_MACRO_SLOTS       16
+#define LINK_MACRO_HEADER_SIZE (8 + 2 * LINK_MACRO_SLOTS)
+#define LINK_MACRO_NO_SLOT     0xFFFF
+#define LINK_MACRO_IMAGE_MAX   4096  /* One flash sector */
+#define LINK_MACRO_MAX_DEPTH   4
+
+#define LINK_MACRO_OP_END      0x00
+#define LINK_MACRO_OP_PRESS    0x01
+#define LINK_MACRO_OP_RELEASE  0x02
+#define LINK_MACRO_OP_HOLD     0x03
+#define LINK_MACRO_OP_WAIT     0x04
+#define LINK_MACRO_OP_LOOP     0x05
+#define LINK_MACRO_OP_NEXT     0x06
+#define LINK_MACRO_OP_TURBO    0x07
+
+/*
+ * Upload (LINK_TYPE_MACRO payload: <op> <args>). The Switch Pico answers
+ * every request with LINK_TYPE_MACRO <op> <status>.
+ *
+ *   BEGIN  <length16>            start a new image
+ *   DATA   <offset16> <bytes>    image bytes, LINK_MACRO_CHUNK_MAX at most
+ *   COMMIT                       check the image and write it to flash
+ */
+#define LINK_MACRO_UPLOAD_BEGIN  0x01
+#define LINK_MACRO_UPLOAD_DATA   0x02
+#define LINK_MACRO_UPLOAD_COMMIT 0x03
+
+#define LINK_MACRO_CHUNK_MAX     128
+
+#define LINK_MACRO_STATUS_OK       0x00
+#define LINK_MACRO_STATUS_BAD_ARGS 0x01  /* Length, offset or op out of range */
+#define LINK_MACRO_STATUS_BAD_IMAGE 0x02 /* Magic, length or CRC mismatch */
+#define LINK_MACRO_STATUS_FLASH    0x03  /* Flash write failed */
+
+#endif /* LINK_MACRO_H */
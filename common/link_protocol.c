@@ -0,0 +1,351 @@
+#include "link_protocol.h"
+#include <string.h>
+
+/* CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), table driven */
+static const uint16_t crc16_table[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+uint16_t link_crc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc = (uint16_t)((crc << 8) ^ crc16_table[((crc >> 8) ^ data[i]) & 0xFF]);
+    }
+    return crc;
+}
+
+/* COBS encode len bytes; returns the encoded size (no delimiter) */
+static size_t cobs_encode(const uint8_t *in, size_t len, uint8_t *out) {
+    size_t code_index = 0;
+    size_t out_index = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_index] = code;
+            code_index = out_index++;
+            code = 1;
+        } else {
+            out[out_index++] = in[i];
+            code++;
+            if (code == 0xFF) {
+                out[code_index] = code;
+                code_index = out_index++;
+                code = 1;
+            }
+        }
+    }
+    out[code_index] = code;
+    return out_index;
+}
+
+/* COBS decode; returns the decoded size, or 0 on a malformed block */
+static size_t cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t out_max) {
+    size_t in_index = 0;
+    size_t out_index = 0;
+
+    while (in_index < len) {
+        uint8_t code = in[in_index++];
+        if (code == 0) {
+            return 0;
+        }
+        for (uint8_t k = 1; k < code; k++) {
+            if (in_index >= len || out_index >= out_max) {
+                return 0;
+            }
+            out[out_index++] = in[in_index++];
+        }
+        if (code < 0xFF && in_index < len) {
+            if (out_index >= out_max) {
+                return 0;
+            }
+            out[out_index++] = 0;
+        }
+    }
+    return out_index;
+}
+
+void link_decoder_init(link_decoder_t *decoder) {
+    memset(decoder, 0, sizeof(*decoder));
+}
+
+static void process_frame(link_decoder_t *decoder, link_frame_handler_t handler, void *ctx) {
+    size_t raw_len = cobs_decode(decoder->encoded, decoder->len, decoder->raw, sizeof(decoder->raw));
+    if (raw_len < LINK_HEADER_SIZE + LINK_CRC_SIZE || decoder->raw[0] != LINK_PROTOCOL_VERSION) {
+        decoder->stats.resyncs++;
+        decoder->stats.breaks++;
+        return;
+    }
+
+    size_t body_len = raw_len - LINK_CRC_SIZE;
+    uint16_t crc = (uint16_t)(decoder->raw[body_len] | (decoder->raw[body_len + 1] << 8));
+    if (crc != link_crc16(decoder->raw, body_len)) {
+        decoder->stats.crc_errors++;
+        decoder->stats.breaks++;
+        return;
+    }
+
+    link_frame_t frame;
+    frame.type = decoder->raw[1];
+    frame.seq = decoder->raw[2];
+    frame.len = (uint8_t)(body_len - LINK_HEADER_SIZE);
+    frame.payload = &decoder->raw[LINK_HEADER_SIZE];
+    frame.encoded = decoder->encoded;
+    frame.encoded_len = decoder->len;
+
+    if (decoder->have_seq) {
+        /* Large jumps mean the sender restarted, not that 128+ frames vanished */
+        uint8_t gap = (uint8_t)(frame.seq - decoder->last_seq - 1);
+        if (gap < 128) {
+            decoder->stats.frames_lost += gap;
+        }
+        if (gap != 0) {
+            decoder->stats.breaks++;
+        }
+    }
+    decoder->have_seq = true;
+    decoder->last_seq = frame.seq;
+    decoder->stats.frames_ok++;
+
+    handler(&frame, ctx);
+}
+
+void link_decoder_feed(link_decoder_t *decoder, const uint8_t *data, size_t len,
+                       link_frame_handler_t handler, void *ctx) {
+    while (len > 0) {
+        const uint8_t *delimiter = memchr(data, LINK_DELIMITER, len);
+        size_t segment = delimiter ? (size_t)(delimiter - data) : len;
+
+        if (!decoder->overflow) {
+            if (decoder->len + segment > sizeof(decoder->encoded)) {
+                /* Longer than any valid frame: drop it and hunt for a delimiter */
+                decoder->overflow = true;
+                decoder->stats.resyncs++;
+                decoder->stats.breaks++;
+            } else {
+                memcpy(&decoder->encoded[decoder->len], data, segment);
+                decoder->len += segment;
+            }
+        }
+
+        if (!delimiter) {
+            return;
+        }
+
+        if (!decoder->overflow && decoder->len > 0) {
+            process_frame(decoder, handler, ctx);
+        }
+        decoder->len = 0;
+        decoder->overflow = false;
+
+        data += segment + 1;
+        len -= segment + 1;
+    }
+}
+
+void link_encoder_init(link_encoder_t *encoder) {
+    encoder->seq = 0;
+}
+
+size_t link_encode(link_encoder_t *encoder, uint8_t type,
+                   const uint8_t *payload, size_t len, uint8_t *out) {
+    uint8_t raw[LINK_MAX_RAW];
+
+    if (len > LINK_MAX_PAYLOAD) {
+        return 0;
+    }
+
+    raw[0] = LINK_PROTOCOL_VERSION;
+    raw[1] = type;
+    raw[2] = encoder->seq++;
+    if (len > 0) {
+        memcpy(&raw[LINK_HEADER_SIZE], payload, len);
+    }
+
+    size_t body_len = LINK_HEADER_SIZE + len;
+    uint16_t crc = link_crc16(raw, body_len);
+    raw[body_len] = (uint8_t)(crc & 0xFF);
+    raw[body_len + 1] = (uint8_t)(crc >> 8);
+
+    size_t encoded_len = cobs_encode(raw, body_len + LINK_CRC_SIZE, out);
+    out[encoded_len++] = LINK_DELIMITER;
+    return encoded_len;
+}
+
+void link_put_u32(uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t)(value & 0xFF);
+    p[1] = (uint8_t)((value >> 8) & 0xFF);
+    p[2] = (uint8_t)((value >> 16) & 0xFF);
+    p[3] = (uint8_t)((value >> 24) & 0xFF);
+}
+
+uint32_t link_get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void link_ack_pack(const link_ack_t *ack, uint8_t *payload) {
+    payload[0] = ack->seq;
+    link_put_u32(&payload[1], ack->rx_us);
+    link_put_u32(&payload[5], ack->report_us);
+}
+
+bool link_ack_unpack(const uint8_t *payload, size_t len, link_ack_t *ack) {
+    if (len < LINK_ACK_SIZE) {
+        return false;
+    }
+    ack->seq = payload[0];
+    ack->rx_us = link_get_u32(&payload[1]);
+    ack->report_us = link_get_u32(&payload[5]);
+    return true;
+}
+
+size_t link_output_pack(const link_output_t *output, uint8_t *payload) {
+    size_t len = output->len > LINK_OUTPUT_MAX_DATA ? LINK_OUTPUT_MAX_DATA : output->len;
+
+    payload[0] = output->controller;
+    payload[1] = output->report_id;
+    memcpy(&payload[LINK_OUTPUT_HEADER_SIZE], output->data, len);
+    return LINK_OUTPUT_HEADER_SIZE + len;
+}
+
+bool link_output_unpack(const uint8_t *payload, size_t len, link_output_t *output) {
+    if (len < LINK_OUTPUT_HEADER_SIZE || len > LINK_OUTPUT_HEADER_SIZE + LINK_OUTPUT_MAX_DATA) {
+        return false;
+    }
+    output->controller = payload[0];
+    output->report_id = payload[1];
+    output->len = (uint8_t)(len - LINK_OUTPUT_HEADER_SIZE);
+    memcpy(output->data, &payload[LINK_OUTPUT_HEADER_SIZE], output->len);
+    return true;
+}
+
+void link_delta_init(link_delta_t *delta, uint16_t keyframe_interval) {
+    memset(delta, 0, sizeof(*delta));
+    delta->keyframe_interval = keyframe_interval;
+}
+
+void link_delta_reset(link_delta_t *delta) {
+    delta->valid = false;
+}
+
+size_t link_delta_encode(link_delta_t *delta, const uint8_t *state,
+                         uint8_t *type, uint8_t *payload) {
+    size_t len = 1;
+
+    if (!delta->valid || (delta->keyframe_interval != 0 &&
+                          ++delta->since_keyframe >= delta->keyframe_interval)) {
+        memcpy(delta->state, state, LINK_STATE_SIZE);
+        memcpy(payload, state, LINK_STATE_SIZE);
+        delta->valid = true;
+        delta->since_keyframe = 0;
+        *type = LINK_TYPE_STATE;
+        len = LINK_STATE_SIZE;
+    } else {
+        payload[0] = 0;
+        for (int i = 0; i < LINK_STATE_SIZE; i++) {
+            if (state[i] != delta->state[i]) {
+                payload[0] |= (uint8_t)(1u << i);
+                payload[len++] = state[i];
+                delta->state[i] = state[i];
+            }
+        }
+        *type = LINK_TYPE_DELTA;
+    }
+
+    if (delta->controller != 0) {
+        payload[len++] = delta->controller;
+    }
+    return len;
+}
+
+/* Bytes a DELTA payload with this mask carries before the controller byte */
+static size_t delta_state_len(uint8_t mask) {
+    size_t len = 1;
+    for (; mask != 0; mask >>= 1) {
+        len += mask & 1;
+    }
+    return len;
+}
+
+uint8_t link_state_controller(const link_frame_t *frame) {
+    size_t len;
+
+    if (frame->type == LINK_TYPE_STATE) {
+        len = LINK_STATE_SIZE;
+    } else if (frame->type == LINK_TYPE_DELTA && frame->len >= 1) {
+        len = delta_state_len(frame->payload[0]);
+    } else {
+        return 0;
+    }
+    return frame->len > len ? frame->payload[len] : 0;
+}
+
+bool link_delta_decode(link_delta_t *delta, const link_frame_t *frame,
+                       const link_rx_stats_t *stats) {
+    /* Any frame missed, reordered or replayed since the last one may have
+     * been a delta: the base is stale */
+    if (stats->breaks != delta->breaks) {
+        delta->breaks = stats->breaks;
+        delta->valid = false;
+    }
+
+    if (frame->type == LINK_TYPE_STATE) {
+        if (frame->len < LINK_STATE_SIZE) {
+            return false;
+        }
+        memcpy(delta->state, frame->payload, LINK_STATE_SIZE);
+        delta->valid = true;
+        return true;
+    }
+
+    if (frame->type != LINK_TYPE_DELTA || frame->len < 1 || !delta->valid) {
+        return false;
+    }
+
+    uint8_t mask = frame->payload[0];
+    size_t len = 1;
+    uint8_t state[LINK_STATE_SIZE];
+    memcpy(state, delta->state, LINK_STATE_SIZE);
+    for (int i = 0; i < LINK_STATE_SIZE; i++) {
+        if (mask & (1u << i)) {
+            if (len >= frame->len) {
+                delta->valid = false;  /* Truncated: out of step now */
+                return false;
+            }
+            state[i] = frame->payload[len++];
+        }
+    }
+    memcpy(delta->state, state, LINK_STATE_SIZE);
+    return true;
+}
@@ -0,0 +1,209 @@
+#ifndef LINK_PROTOCOL_H
+#define LINK_PROTOCOL_H
+
+/*
+ * Inter-Pico / PC link protocol
+ *
+ * Shared by the Switch Pico firmware, both uart-bridge firmwares and the
+ * controller_bridge PC application.
+ *
+ * Frame layout before encoding:
+ *
+ *   [0]      protocol version (LINK_PROTOCOL_VERSION)
+ *   [1]      frame type (LINK_TYPE_*)
+ *   [2]      sequence number, incremented by the sender for every frame
+ *   [3..n-3] payload (0..LINK_MAX_PAYLOAD bytes)
+ *   [n-2..]  CRC-16/CCITT-FALSE of bytes 0..n-3, little endian
+ *
+ * The frame is COBS-encoded, so it contains no zero bytes, and terminated
+ * by a single 0x00 delimiter. A receiver that loses sync (noise, dropped
+ * bytes) realigns at the next delimiter, so a damaged frame never costs
+ * more than itself.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define LINK_PROTOCOL_VERSION 1
+
+#define LINK_DELIMITER    0x00
+#define LINK_HEADER_SIZE  3
+#define LINK_CRC_SIZE     2
+#define LINK_MAX_PAYLOAD  240
+#define LINK_MAX_RAW      (LINK_HEADER_SIZE + LINK_MAX_PAYLOAD + LINK_CRC_SIZE)
+/* COBS adds one byte per 254 (a single block here) plus the delimiter */
+#define LINK_MAX_ENCODED  (LINK_MAX_RAW + 2)
+
+/* Frame types */
+#define LINK_TYPE_STATE    0x01  /* 8-byte controller state (HID report layout) [+ controller] */
+#define LINK_TYPE_COMMAND  0x02  /* <command> <value> runtime setting */
+#define LINK_TYPE_BAUD     0x03  /* uint32 baud rate: request, echoed to accept */
+#define LINK_TYPE_PING     0x04  /* Arbitrary payload, answered with a PONG */
+#define LINK_TYPE_PONG     0x05  /* Echo of the PING payload */
+#define LINK_TYPE_ACK      0x06  /* Upstream: newest frame a HID report carried */
+#define LINK_TYPE_TIME     0x07  /* Clock sync: uint32 token, answered with token + Pico time */
+#define LINK_TYPE_TIMED_STATE 0x08  /* uint32 target Pico time + state, queued on the Pico */
+#define LINK_TYPE_MACRO    0x09  /* Macro image upload, see link_macro.h */
+#define LINK_TYPE_DELTA    0x0A  /* Changed state bytes only, see link_delta_t [+ controller] */
+#define LINK_TYPE_OUTPUT   0x0B  /* Upstream: output report from the console, see link_output_t */
+#define LINK_TYPE_STATS    0x0C  /* Counter query: device, answered with its counters (link_stats.h) */
+
+/* Commands carried by LINK_TYPE_COMMAND */
+#define LINK_CMD_REPORT_INTERVAL 0x01  /* value: 1, 2, 4 or 8 ms */
+#define LINK_CMD_REPORT_MODE     0x02  /* value: 0 = periodic, 1 = event-driven */
+#define LINK_CMD_TIMELINE_CLEAR  0x03  /* value ignored: drop queued timed states */
+#define LINK_CMD_MACRO_RUN       0x04  /* value: macro slot to start */
+#define LINK_CMD_MACRO_STOP      0x05  /* value ignored: stop the macro, turbo off */
+#define LINK_CMD_TAP_HOLD        0x06  /* value: reports every press is held for at least, 0 = off */
+
+/* Controller state payload (same layout as the Switch HID report) */
+#define LINK_STATE_SIZE 8
+
+/* STATE and DELTA payloads may end in one more byte, the virtual controller
+ * (HID interface) they are for. Without it they are for controller 0, so a
+ * single-controller sender never adds it. */
+#define LINK_MAX_CONTROLLERS 4
+
+/* Timed state payload: target time_us_32() on the Switch Pico, then state */
+#define LINK_TIMED_STATE_SIZE (4 + LINK_STATE_SIZE)
+
+/* Clock sync reply: the request's token, then the Switch Pico time_us_32() */
+#define LINK_TIME_REPLY_SIZE 8
+
+/* Acknowledgement payload: seq, rx_us, report_us (little endian) */
+#define LINK_ACK_SIZE 9
+
+/* Output report payload: controller, report ID, then the report bytes as
+ * the console sent them (up to the HID endpoint size) */
+#define LINK_OUTPUT_HEADER_SIZE 2
+#define LINK_OUTPUT_MAX_DATA    64
+
+/* Delta payload: a mask with bit i set for every state byte i that follows,
+ * in order. One keyboard button change is 2 bytes instead of 8. */
+#define LINK_DELTA_MAX_SIZE (1 + LINK_STATE_SIZE + 1)
+
+/* Full STATE keyframe every this many state frames, so a receiver that lost
+ * a frame is back in step soon */
+#define LINK_DELTA_KEYFRAME_DEFAULT 100
+
+/* Encoded size of a frame with a payload of n bytes */
+#define LINK_ENCODED_SIZE(n) (LINK_HEADER_SIZE + (n) + LINK_CRC_SIZE + 2)
+
+typedef struct {
+    uint8_t type;
+    uint8_t seq;
+    uint8_t len;
+    const uint8_t *payload;
+    const uint8_t *encoded;    /* Original COBS bytes, without the delimiter */
+    size_t encoded_len;
+} link_frame_t;
+
+typedef struct {
+    uint32_t frames_ok;
+    uint32_t frames_lost;      /* Sequence numbers skipped between good frames */
+    uint32_t crc_errors;       /* Well-formed frames whose CRC did not match */
+    uint32_t resyncs;          /* Bad COBS, short, oversize or wrong-version frames */
+    uint32_t breaks;           /* Resyncs, CRC errors and seqs not following the last */
+} link_rx_stats_t;
+
+/* Sent by the Switch Pico after a HID report that carried a newer frame.
+ * Timestamps are the Switch Pico's time_us_32(); only their difference is
+ * meaningful to the PC. */
+typedef struct {
+    uint8_t seq;               /* Sequence number of the frame */
+    uint32_t rx_us;            /* When the frame was taken off the link */
+    uint32_t report_us;        /* When tud_hid_report() carried it */
+} link_ack_t;
+
+/* An output report (rumble, player LEDs) the console sent to one of the
+ * Switch Pico's controllers with SET_REPORT, forwarded to the PC */
+typedef struct {
+    uint8_t controller;
+    uint8_t report_id;
+    uint8_t len;
+    uint8_t data[LINK_OUTPUT_MAX_DATA];
+} link_output_t;
+
+/* State tracking on either end of a hop that carries DELTA frames. A
+ * receiver only applies deltas on top of a keyframe it has seen with no
+ * frame lost since; until the next keyframe it ignores them. */
+typedef struct {
+    uint8_t state[LINK_STATE_SIZE];
+    bool valid;                /* state is in step with the other end */
+    uint16_t keyframe_interval; /* Sender: 1 = no deltas, 0 = only after a reset */
+    uint16_t since_keyframe;
+    uint8_t controller;        /* Sender: controller byte appended if not 0 */
+    uint32_t breaks;           /* Receiver: decoder break count last seen */
+} link_delta_t;
+
+typedef void (*link_frame_handler_t)(const link_frame_t *frame, void *ctx);
+
+typedef struct {
+    uint8_t encoded[LINK_MAX_ENCODED];
+    uint8_t raw[LINK_MAX_RAW];
+    size_t len;
+    bool overflow;             /* Discarding until the next delimiter */
+    bool have_seq;
+    uint8_t last_seq;
+    link_rx_stats_t stats;
+} link_decoder_t;
+
+typedef struct {
+    uint8_t seq;
+} link_encoder_t;
+
+uint16_t link_crc16(const uint8_t *data, size_t len);
+
+void link_decoder_init(link_decoder_t *decoder);
+
+/* Feed received bytes; handler runs once for every valid frame. The frame
+ * and its payload are only valid during the callback. */
+void link_decoder_feed(link_decoder_t *decoder, const uint8_t *data, size_t len,
+                       link_frame_handler_t handler, void *ctx);
+
+void link_encoder_init(link_encoder_t *encoder);
+
+/* Encode one frame into out (at least LINK_ENCODED_SIZE(len) bytes) and
+ * return its size including the delimiter, or 0 if len is too large. */
+size_t link_encode(link_encoder_t *encoder, uint8_t type,
+                   const uint8_t *payload, size_t len, uint8_t *out);
+
+/* Little-endian helpers for multi-byte payload fields */
+void link_put_u32(uint8_t *p, uint32_t value);
+uint32_t link_get_u32(const uint8_t *p);
+
+void link_ack_pack(const link_ack_t *ack, uint8_t *payload);
+
+/* Returns false if the payload is too short */
+bool link_ack_unpack(const uint8_t *payload, size_t len, link_ack_t *ack);
+
+/* Returns the payload length (payload must hold LINK_OUTPUT_HEADER_SIZE +
+ * LINK_OUTPUT_MAX_DATA bytes) */
+size_t link_output_pack(const link_output_t *output, uint8_t *payload);
+
+/* Returns false if the payload is too short or too long */
+bool link_output_unpack(const uint8_t *payload, size_t len, link_output_t *output);
+
+void link_delta_init(link_delta_t *delta, uint16_t keyframe_interval);
+
+/* Sender: next frame is a keyframe */
+void link_delta_reset(link_delta_t *delta);
+
+/* Sender: build the frame for a state, a DELTA against the previous one or a
+ * STATE keyframe. Sets *type and returns the payload length (payload must
+ * hold LINK_DELTA_MAX_SIZE bytes). */
+size_t link_delta_encode(link_delta_t *delta, const uint8_t *state,
+                         uint8_t *type, uint8_t *payload);
+
+/* Controller a STATE or DELTA frame is for (0 if it names none). Pick the
+ * receiver's link_delta_t by this before decoding. */
+uint8_t link_state_controller(const link_frame_t *frame);
+
+/* Receiver: apply a STATE or DELTA frame to delta->state. stats are the
+ * decoder's counters, used to spot a break in the stream. Returns true if
+ * delta->state now holds a new, trustworthy state. */
+bool link_delta_decode(link_delta_t *delta, const link_frame_t *frame,
+                       const link_rx_stats_t *stats);
+
+#endif /* LINK_PROTOCOL_H */
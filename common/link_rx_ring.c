@@ -0,0 +1,95 @@
+#include "link_rx_ring.h"
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+#define LINK_RX_RING_MASK (LINK_RX_RING_SIZE - 1)
+
+/* Transfer count programmed into the channel; a multiple of the ring size
+ * so the byte counter below stays aligned with the write address */
+#define RX_DMA_TRANSFER_COUNT 0x80000000u
+
+static uint8_t rx_ring[LINK_RX_RING_SIZE] __attribute__((aligned(LINK_RX_RING_SIZE)));
+static int rx_dma_chan = -1;
+static volatile uint32_t rx_dma_rearms = 0;
+static uint32_t rx_read_total = 0;
+static link_rx_ring_stats_t stats = {0};
+
+static void rx_dma_irq_handler(void) {
+    if (!dma_channel_get_irq1_status(rx_dma_chan)) {
+        return;
+    }
+    dma_channel_acknowledge_irq1(rx_dma_chan);
+
+    /* Restart the endless transfer; the write address keeps wrapping */
+    rx_dma_rearms++;
+    dma_channel_set_trans_count(rx_dma_chan, RX_DMA_TRANSFER_COUNT, true);
+}
+
+/* Total number of bytes the DMA has written (mod 2^32) */
+static uint32_t rx_written_total(void) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    uint32_t remaining = dma_hw->ch[rx_dma_chan].transfer_count;
+    uint32_t rearms = rx_dma_rearms;
+    restore_interrupts(irq_state);
+
+    return rearms * RX_DMA_TRANSFER_COUNT + (RX_DMA_TRANSFER_COUNT - remaining);
+}
+
+void link_rx_ring_init(unsigned int dreq, const volatile void *src) {
+    rx_dma_chan = dma_claim_unused_channel(true);
+
+    dma_channel_config cfg = dma_channel_get_default_config(rx_dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_ring(&cfg, true, LINK_RX_RING_BITS);
+    channel_config_set_dreq(&cfg, dreq);
+
+    dma_channel_set_irq1_enabled(rx_dma_chan, true);
+    irq_add_shared_handler(DMA_IRQ_1, rx_dma_irq_handler,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    dma_channel_configure(rx_dma_chan, &cfg,
+                          rx_ring,
+                          src,
+                          RX_DMA_TRANSFER_COUNT,
+                          true);
+}
+
+size_t link_rx_ring_peek(const uint8_t **data) {
+    uint32_t written = rx_written_total();
+    uint32_t available = written - rx_read_total;
+
+    if (available >= LINK_RX_RING_SIZE) {
+        /* The writer caught up with us: with a full ring the next byte
+         * lands on the oldest one, possibly mid-parse, and past that older
+         * bytes are already gone. Skip ahead and keep the newest half. */
+        uint32_t keep = LINK_RX_RING_SIZE / 2;
+        stats.ring_overflows++;
+        stats.dropped_bytes += available - keep;
+        rx_read_total = written - keep;
+        available = keep;
+    }
+
+    if (available == 0) {
+        return 0;
+    }
+
+    uint32_t pos = rx_read_total & LINK_RX_RING_MASK;
+    uint32_t contiguous = LINK_RX_RING_SIZE - pos;
+
+    *data = &rx_ring[pos];
+    return available < contiguous ? available : contiguous;
+}
+
+void link_rx_ring_consume(size_t len) {
+    rx_read_total += len;
+}
+
+void link_rx_ring_get_stats(link_rx_ring_stats_t *out) {
+    *out = stats;
+}
@@ -0,0 +1,43 @@
+#ifndef LINK_RX_RING_H
+#define LINK_RX_RING_H
+
+/*
+ * DMA receive ring (RP2040 firmwares only)
+ *
+ * A DMA channel paced by the receiver's DREQ copies every byte into a
+ * power-of-two buffer. The channel writes with a hardware address ring, so
+ * the write pointer wraps by itself; the only CPU involvement is re-arming
+ * the transfer count once every 2^31 bytes. Used for whichever peripheral
+ * carries the link (UART or the PIO synchronous receiver).
+ *
+ * One ring per firmware; the consumer peeks at the largest contiguous chunk
+ * available, parses it, then consumes it.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Ring size in bytes (power of two; the buffer is aligned to its size so
+ * the DMA write address can wrap in hardware) */
+#define LINK_RX_RING_BITS 10
+#define LINK_RX_RING_SIZE (1u << LINK_RX_RING_BITS)
+
+typedef struct {
+    uint32_t ring_overflows;  /* Times the DMA writer lapped the consumer */
+    uint32_t dropped_bytes;   /* Bytes discarded because of ring overflows */
+} link_rx_ring_stats_t;
+
+/* Start the endless transfer from src (a peripheral data register or FIFO
+ * paced by dreq). The DMA completion IRQ is installed on the calling core. */
+void link_rx_ring_init(unsigned int dreq, const volatile void *src);
+
+/* Return the number of contiguous bytes ready to parse and point *data at
+ * them. Returns 0 when the ring is empty. */
+size_t link_rx_ring_peek(const uint8_t **data);
+
+/* Release len bytes previously returned by link_rx_ring_peek() */
+void link_rx_ring_consume(size_t len);
+
+void link_rx_ring_get_stats(link_rx_ring_stats_t *stats);
+
+#endif /* LINK_RX_RING_H */
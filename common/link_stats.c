@@ -0,0 +1,35 @@
+#include "link_stats.h"
+#include "link_protocol.h"
+
+void link_stats_hist_add(uint32_t *hist, uint32_t *max_us, uint32_t us) {
+    int bucket = 0;
+    while (bucket < LINK_STATS_BUCKETS - 1 && (us >> (bucket + 1)) != 0) {
+        bucket++;
+    }
+    hist[bucket]++;
+    if (us > *max_us) {
+        *max_us = us;
+    }
+}
+
+void link_stats_pack(uint8_t device, const link_stats_t *stats, uint8_t *payload) {
+    const uint32_t *words = (const uint32_t *)stats;
+
+    payload[0] = device;
+    for (size_t i = 0; i < LINK_STATS_WORDS; i++) {
+        link_put_u32(&payload[1 + 4 * i], words[i]);
+    }
+}
+
+bool link_stats_unpack(const uint8_t *payload, size_t len, uint8_t *device, link_stats_t *stats) {
+    uint32_t *words = (uint32_t *)stats;
+
+    if (len < LINK_STATS_REPLY_SIZE) {
+        return false;
+    }
+    *device = payload[0];
+    for (size_t i = 0; i < LINK_STATS_WORDS; i++) {
+        words[i] = link_get_u32(&payload[1 + 4 * i]);
+    }
+    return true;
+}
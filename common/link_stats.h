@@ -0,0 +1,66 @@
+#ifndef LINK_STATS_H
+#define LINK_STATS_H
+
+/*
+ * Performance counters, queried over the link
+ *
+ * Both Picos keep one fixed-size counter block. The PC sends a
+ * LINK_TYPE_STATS request naming the device; the bridge Pico answers for
+ * itself or passes the request on to the Switch Pico and relays its answer.
+ *
+ *   request  [device]
+ *   reply    [device] [counter block, LINK_STATS_BLOCK_SIZE bytes]
+ *
+ * The block is a list of little-endian uint32 in link_stats_t order.
+ * Counters wrap; compare two queries to get rates.
+ *
+ * Histograms count durations in microseconds by powers of two: bucket 0 is
+ * below 2 us, bucket i (0 < i < last) holds [2^i, 2^(i+1)) us and the last
+ * bucket everything from 2^(LINK_STATS_BUCKETS - 1) us up.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define LINK_STATS_BRIDGE 0x00
+#define LINK_STATS_SWITCH 0x01
+
+#define LINK_STATS_BUCKETS 16
+
+typedef struct {
+    uint32_t uptime_ms;
+    uint32_t frames_ok;        /* Decoder counters for frames received (the
+                                * bridge counts frames from the PC) */
+    uint32_t frames_lost;
+    uint32_t crc_errors;
+    uint32_t resyncs;
+    uint32_t rx_overruns;      /* Link receiver FIFO overruns (UART OE, PIO RX stall) */
+    uint32_t ring_overflows;   /* DMA receive ring lapped by the writer */
+    uint32_t reports_sent;     /* Switch Pico: HID reports; bridge: frames forwarded */
+    uint32_t hid_not_ready;    /* Switch Pico: report due but the endpoint was busy */
+    uint32_t frames_coalesced; /* Bridge: states replaced by a newer one before the
+                                * link could take them */
+    uint32_t loop_max_us;      /* Longest main loop pass */
+    uint32_t loop_hist[LINK_STATS_BUCKETS];
+    uint32_t latency_max_us;   /* Switch Pico: frame received -> HID report;
+                                * bridge: frame from the PC -> sent on the link */
+    uint32_t latency_hist[LINK_STATS_BUCKETS];
+    uint32_t latency_last_us;      /* Switch Pico: newest and mean frame -> HID */
+    uint32_t latency_avg_us;       /* report time (0 on the bridge) */
+} link_stats_t;
+
+#define LINK_STATS_WORDS      (sizeof(link_stats_t) / sizeof(uint32_t))
+#define LINK_STATS_BLOCK_SIZE (LINK_STATS_WORDS * 4)
+#define LINK_STATS_REPLY_SIZE (1 + LINK_STATS_BLOCK_SIZE)
+
+/* Count one duration in a histogram and its maximum */
+void link_stats_hist_add(uint32_t *hist, uint32_t *max_us, uint32_t us);
+
+/* Reply payload (LINK_STATS_REPLY_SIZE bytes) */
+void link_stats_pack(uint8_t device, const link_stats_t *stats, uint8_t *payload);
+
+/* Returns false if the payload is not a full reply */
+bool link_stats_unpack(const uint8_t *payload, size_t len, uint8_t *device, link_stats_t *stats);
+
+#endif /* LINK_STATS_H */
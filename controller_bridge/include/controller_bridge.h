@@ -4,6 +4,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include "link_protocol.h"
+#include "link_macro.h"
+#include "link_baud.h"
 
 /* Nintendo Switch button definitions */
 #define BTN_Y       (1 << 0)
@@ -60,6 +63,7 @@ typedef struct {
     uint8_t ly;
     uint8_t rx;
     uint8_t ry;
+    uint8_t macro_key;            /* Held macro key: slot + 1, 0 if none */
 } controller_state_t;
 
 /* Input type enumeration */
@@ -67,7 +71,8 @@ typedef enum {
     INPUT_TYPE_BUTTON,
     INPUT_TYPE_DPAD,
     INPUT_TYPE_LSTICK,
-    INPUT_TYPE_RSTICK
+    INPUT_TYPE_RSTICK,
+    INPUT_TYPE_MACRO              /* Starts a macro stored on the Switch Pico */
 } input_type_t;
 
 /* Input direction enumeration */
@@ -86,6 +91,7 @@ typedef struct {
     union {
         uint16_t button_mask;
         input_direction_t direction;
+        uint8_t macro_slot;
     } value;
 } key_binding_t;
 
@@ -110,10 +116,21 @@ typedef struct {
 typedef struct {
     char serial_port[MAX_PATH_LEN];
     int baud_rate;
+    bool direct_link;             /* USB-UART adapter on the Switch Pico, no bridge Pico */
     bool enable_keyboard;
     bool enable_controller;
     int update_rate_hz;
+    int pacing_spin_us;           /* Busy-wait this long before each poll (0 = off) */
+    int min_frame_gap_us;         /* Per controller, between state frames */
+    int keepalive_ms;             /* Repeat an unchanged state this often (0 = never) */
     int controller_deadzone;
+    int report_interval_ms;       /* Switch Pico HID report interval (1, 2, 4 or 8) */
+    bool event_reporting;         /* Switch Pico sends a report as soon as input changes */
+    int tap_hold_reports;         /* Reports every press is held for at least (0 = off) */
+    int keyframe_interval;        /* Full state every N frames, deltas between (1 = no deltas) */
+    int controllers;              /* Virtual controllers on the Switch Pico to drive (1-4) */
+    bool enable_rumble;           /* Pass console rumble on to the local gamepads */
+    char rumble_device[MAX_PATH_LEN]; /* Linux: event device for controller 1's rumble, "" = its gamepad */
     key_binding_t *bindings;
     int binding_count;
     controller_button_binding_t *controller_bindings;
@@ -129,11 +146,15 @@ typedef struct {
 void controller_state_init(controller_state_t *state);
 void controller_state_update_sticks(controller_state_t *state);
 uint8_t controller_state_get_hat(const controller_state_t *state);
-void controller_state_to_packet(const controller_state_t *state, uint8_t *packet);
+void controller_state_to_payload(const controller_state_t *state, uint8_t *payload);
+size_t controller_state_to_packet(const controller_state_t *state, link_encoder_t *link,
+                                  link_delta_t *delta, uint8_t *packet);
+size_t link_command_to_packet(link_encoder_t *link, uint8_t command, uint8_t value, uint8_t *packet);
 
 /* Configuration */
 bool config_load(config_t *config, const char *filename);
 bool config_create_default(const char *filename);
+uint16_t parse_button_name(const char *name);
 void config_free(config_t *config);
 key_binding_t *config_find_binding(config_t *config, const char *key_name);
 
@@ -142,7 +163,246 @@ typedef void* serial_port_t;
 serial_port_t serial_open(const char *port_name, int baud_rate);
 void serial_close(serial_port_t port);
 bool serial_write(serial_port_t port, const uint8_t *data, size_t len);
+int serial_read(serial_port_t port, uint8_t *data, size_t len);  /* Non-blocking; bytes read or -1 */
 bool serial_is_open(serial_port_t port);
+bool serial_set_baud(serial_port_t port, int baud_rate);  /* After pending output has drained */
+/* USB-UART adapters: ask the driver to pass received bytes on at once (FTDI
+ * latency timer, ASYNC_LOW_LATENCY). Returns false if nothing could be set. */
+bool serial_set_low_latency(serial_port_t port);
+#ifndef _WIN32
+int serial_get_fd(serial_port_t port);  /* For the event loop; -1 if closed */
+#endif
+
+/* Timing */
+uint64_t timing_now_us(void);  /* Monotonic clock in microseconds */
+void timing_sleep_ms(uint32_t ms);
+
+/* Serial writer: a thread that does the main loop's writes, so it never
+ * waits on the wire. Commands are queued and all go out, in order. State
+ * frames go through one slot per controller that a newer frame replaces:
+ * a slow port skips stale states instead of falling behind. Frames are
+ * posted as type and payload and encoded as they go out, so sequence
+ * numbers stay consecutive on the wire. */
+#define SERIAL_WRITER_STALL_US 5000   /* A write this slow counts as a stall */
+
+typedef struct {
+    unsigned long frames;         /* Written */
+    unsigned long superseded;     /* State frames replaced before they went out */
+    unsigned long stalls;         /* Writes of SERIAL_WRITER_STALL_US or more */
+    unsigned long failures;
+    uint64_t last_done_us;        /* When the newest write completed */
+    uint32_t max_write_us;        /* Longest single write */
+    uint32_t max_queued_us;       /* Longest from post to write completed */
+} serial_writer_stats_t;
+
+typedef struct serial_writer serial_writer_t;
+/* The thread encodes with link; leave it alone until serial_writer_destroy */
+serial_writer_t *serial_writer_create(serial_port_t serial, link_encoder_t *link);
+/* Writes out what is still posted, then stops the thread */
+void serial_writer_destroy(serial_writer_t *writer);
+/* Queue a frame that must not be dropped; waits if the queue is full.
+ * Returns false if the last write failed. */
+bool serial_writer_post(serial_writer_t *writer, uint8_t type, const uint8_t *payload,
+                        size_t len);
+/* Replace the controller's unsent state frame, if any */
+bool serial_writer_post_state(serial_writer_t *writer, int controller, uint8_t type,
+                              const uint8_t *payload, size_t len);
+/* The controller's previous state frame is still unsent. One posted now
+ * replaces it, so make it a keyframe (link_delta_reset). */
+bool serial_writer_state_pending(serial_writer_t *writer, int controller);
+/* Wait until everything posted has been written */
+void serial_writer_flush(serial_writer_t *writer);
+/* When the state frame sent with seq started going out; 0 if there is none
+ * on record or it was already taken */
+uint64_t serial_writer_take_sent_us(serial_writer_t *writer, uint8_t seq);
+void serial_writer_get_stats(serial_writer_t *writer, serial_writer_stats_t *stats);
+
+/* End-to-end latency from the acks sent back by the Switch Pico */
+#define LATENCY_MAX_SAMPLES 4096
+
+typedef struct {
+    uint32_t rtt_us;       /* Frame sent -> ack received */
+    uint32_t one_way_us;   /* Frame sent -> HID report that carried it (estimated) */
+} latency_sample_t;
+
+typedef struct {
+    latency_sample_t samples[LATENCY_MAX_SAMPLES];  /* Most recent samples (ring) */
+    size_t count;
+    size_t next;
+    unsigned long acks;
+    unsigned long unmatched_acks;                   /* No send on record, or inconsistent */
+} latency_tracker_t;
+
+typedef struct {
+    size_t samples;
+    uint32_t rtt_p50_us;
+    uint32_t rtt_p99_us;
+    uint32_t one_way_p50_us;
+    uint32_t one_way_p99_us;
+} latency_summary_t;
+
+void latency_init(latency_tracker_t *tracker);
+/* sent_us: when the acked frame went out (serial_writer_take_sent_us) */
+void latency_on_ack(latency_tracker_t *tracker, const link_ack_t *ack, uint64_t sent_us,
+                    uint64_t now_us);
+bool latency_get_summary(const latency_tracker_t *tracker, latency_summary_t *summary);
+
+/* Send policy for one controller: a state frame goes out as soon as the state
+ * changes, but no sooner than min_gap_us after the previous one, and an
+ * unchanged state is repeated every keepalive (0 = never). States are the
+ * LINK_STATE_SIZE payload bytes. */
+typedef enum {
+    SEND_NONE,
+    SEND_CHANGE,
+    SEND_KEEPALIVE             /* Send as a keyframe, so a lost delta gets repaired */
+} send_reason_t;
+
+typedef struct {
+    uint8_t last[LINK_STATE_SIZE];  /* Last state sent */
+    bool have_last;                 /* false: send the next state whatever it is */
+    bool pending;                   /* A change is waiting out the gap */
+    uint64_t last_send_us;
+    uint32_t min_gap_us;
+    uint32_t keepalive_us;
+} send_policy_t;
+
+void send_policy_init(send_policy_t *policy, int min_gap_us, int keepalive_ms);
+/* The next state goes out whether it changed or not */
+void send_policy_reset(send_policy_t *policy);
+send_reason_t send_policy_check(send_policy_t *policy, const uint8_t *state, uint64_t now_us);
+void send_policy_on_sent(send_policy_t *policy, const uint8_t *state, uint64_t now_us);
+/* When send_policy_check may next say to send without the input changing;
+ * UINT64_MAX if never */
+uint64_t send_policy_due_us(const send_policy_t *policy);
+
+/* Pacing for input polling where the event loop can't wake on input
+ * (EVENT_LOOP_WAKES_ON_INPUT is 0): deadlines on a fixed grid at
+ * update_rate_hz from the start, so time spent sending doesn't stretch the
+ * period and a configured rate is the rate achieved. How late each deadline
+ * was served is kept as the jitter. It paces polls, not frames; frames go
+ * out when send_policy_t says so. */
+#define PACER_MAX_SAMPLES 4096
+
+typedef struct {
+    int rate_hz;
+    uint32_t spin_us;                        /* Wake this early, then spin to the deadline */
+    uint64_t start_us;
+    uint64_t tick;                           /* Deadline number since start_us */
+    uint64_t deadline_us;
+    uint32_t lateness_us[PACER_MAX_SAMPLES]; /* Most recent wakeups (ring) */
+    size_t count;
+    size_t next;
+    unsigned long missed;                    /* Deadlines skipped, a period or more late */
+    unsigned long window_ticks;              /* Since window_start_us, for the achieved rate */
+    uint64_t window_start_us;
+} pacer_t;
+
+typedef struct {
+    int target_hz;
+    double rate_hz;           /* Polls a second since the previous summary */
+    unsigned long missed;
+    uint32_t jitter_p50_us;
+    uint32_t jitter_p99_us;
+    uint32_t jitter_max_us;
+} pacer_summary_t;
+
+void pacer_init(pacer_t *pacer, int rate_hz, int spin_us, uint64_t now_us);
+/* When to wake up for the next deadline (the deadline less the spin tail) */
+uint64_t pacer_wake_us(const pacer_t *pacer);
+/* Woken for the deadline: spin out the tail, record, move to the next one */
+void pacer_on_wake(pacer_t *pacer);
+/* Also starts a new window for the achieved rate */
+bool pacer_get_summary(pacer_t *pacer, pacer_summary_t *summary, uint64_t now_us);
+
+/* Output reports the console sent the Switch Pico's controllers (rumble,
+ * player LEDs), decoded from LINK_TYPE_OUTPUT frames as they arrive */
+typedef struct {
+    link_output_t report;
+    uint64_t received_us;      /* timing_now_us() when it was decoded */
+    bool changed;              /* Differs from the previous one for this controller */
+} output_event_t;
+
+typedef void (*output_sink_t)(const output_event_t *event, void *ctx);
+
+typedef struct {
+    output_event_t last[LINK_MAX_CONTROLLERS];  /* Newest per controller */
+    bool seen[LINK_MAX_CONTROLLERS];
+    unsigned long events;
+    output_sink_t sink;                         /* Called for every event */
+    void *sink_ctx;
+} output_tracker_t;
+
+void output_init(output_tracker_t *tracker, output_sink_t sink, void *sink_ctx);
+/* Returns true if the frame was an output report (handled or malformed) */
+bool output_on_frame(output_tracker_t *tracker, const link_frame_t *frame, uint64_t now_us);
+
+/* Rumble for a local two-motor pad, decoded from an 8-byte output report.
+ * Magnitudes are 0-65535; both 0 means stop. */
+typedef struct {
+    uint16_t strong;
+    uint16_t weak;
+} rumble_t;
+
+bool rumble_from_output(const link_output_t *report, rumble_t *rumble);
+
+/* Timeline playback: stream a file of timed states to the Switch Pico, which
+ * applies each one at its scheduled time. Blocks until done or *running is
+ * cleared. */
+bool timeline_play(serial_port_t serial, link_encoder_t *link, const char *filename,
+                   volatile bool *running);
+
+/* Macros: assemble a macro file and store it on the Switch Pico (see
+ * link_macro.h for the bytecode) */
+bool macros_upload(serial_port_t serial, link_encoder_t *link, const char *filename);
+
+/* Direct mode: controller_bridge on the Switch Pico's UART through a USB-UART
+ * adapter, no bridge Pico. This end takes the bridge Pico's part in the baud
+ * negotiation (see link_baud.h). */
+typedef struct {
+    link_baud_master_t master;
+    serial_port_t serial;
+    serial_writer_t *writer;      /* Writes go through it, as the state frames' do */
+    bool rate_changed;
+    uint32_t reported_baud;       /* Last rate logged, 0 before the first */
+} direct_link_t;
+
+void direct_link_init(direct_link_t *direct, serial_port_t serial, serial_writer_t *writer);
+/* Advance the negotiation. Returns true if the rate changed since the last
+ * call: frames around the switch may be lost, so send keyframes next. */
+bool direct_link_poll(direct_link_t *direct, const link_rx_stats_t *rx_stats);
+/* Returns true if the frame was a link-management reply (consumed) */
+bool direct_link_handle_frame(direct_link_t *direct, const link_frame_t *frame);
+/* When direct_link_poll next has something to do (a timeout or keepalive) */
+uint64_t direct_link_due_us(const direct_link_t *direct);
+
+/* Counters: query both Picos for their performance counters (see
+ * link_stats.h) and print them; only the Switch Pico in direct mode.
+ * Returns false if none answered. */
+bool stats_query(serial_port_t serial, link_encoder_t *link, bool direct);
+
+/* Event loop: the main loop sleeps here until input arrives, the serial port
+ * has data or a deadline passes. Linux waits in epoll on the input devices,
+ * the serial port and a timerfd; other platforms sleep until the deadline and
+ * report everything as ready. */
+#define EVENT_INPUT  0x01
+#define EVENT_SERIAL 0x02
+#define EVENT_TIMER  0x04
+
+/* Linux wakes for input itself, so the main loop only needs to wake for its
+ * own deadlines; elsewhere input is polled and has to be sampled on a grid
+ * (pacer_t) */
+#if defined(__linux__)
+#define EVENT_LOOP_WAKES_ON_INPUT 1
+#else
+#define EVENT_LOOP_WAKES_ON_INPUT 0
+#endif
+
+typedef struct event_loop event_loop_t;
+event_loop_t *event_loop_create(serial_port_t serial, const config_t *config);
+void event_loop_destroy(event_loop_t *loop);
+/* Returns EVENT_* flags, EVENT_TIMER once timing_now_us() reaches deadline_us;
+ * 0 if interrupted by a signal */
+int event_loop_wait(event_loop_t *loop, uint64_t deadline_us);
 
 /* Input handler */
 typedef struct input_handler input_handler_t;
@@ -157,8 +417,28 @@ bool platform_input_init(void);
 void platform_input_cleanup(void);
 void platform_input_poll(controller_state_t *state, config_t *config);
 
+/* Gamepad routed to virtual controller slot (1 .. LINK_MAX_CONTROLLERS - 1):
+ * slot 0 is the keyboard and first gamepad polled above, slot n the n+1th
+ * gamepad. Returns false if there is no such gamepad. */
+bool platform_input_poll_gamepad(int slot, controller_state_t *state, config_t *config);
+
+#ifdef __linux__
+/* The device fds the polls above drain with this config, for the event loop.
+ * Returns how many were stored. */
+int platform_input_get_fds(const config_t *config, int *fds, int max);
+/* The device behind fd is gone (unplugged): close it and poll without it */
+void platform_input_close_fd(int fd);
+#endif
+
+/* Rumble the gamepad routed to slot. Repeating the current magnitudes costs
+ * nothing. Returns false if that pad can't rumble (or the platform can't). */
+bool platform_rumble(int slot, const rumble_t *rumble, const config_t *config);
+
 /* Global raw stick values for calibration (set by platform code) */
 extern int g_raw_lx, g_raw_ly, g_raw_rx, g_raw_ry;
+/* Index of the controller button last pressed, as [ControllerBindings]
+ * numbers them; -1 if the platform doesn't report it (set by platform code) */
+extern int g_raw_button;
 
 /* Calibration helper function */
 uint8_t apply_stick_calibration(int raw_value, const stick_calibration_t *cal, bool is_y_axis);
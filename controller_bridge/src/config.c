@@ -24,7 +24,7 @@ static char *trim_whitespace(char *str) {
 }
 
 /* Helper to parse button name */
-static uint16_t parse_button_name(const char *name) {
+uint16_t parse_button_name(const char *name) {
     if (strcmp(name, "A") == 0) return BTN_A;
     if (strcmp(name, "B") == 0) return BTN_B;
     if (strcmp(name, "X") == 0) return BTN_X;
@@ -64,10 +64,21 @@ bool config_load(config_t *config, const char *filename) {
     /* Set defaults */
     strcpy(config->serial_port, "COM3");
     config->baud_rate = 115200;
+    config->direct_link = false;
     config->enable_keyboard = true;
     config->enable_controller = true;
     config->update_rate_hz = 1000;
+    config->pacing_spin_us = 0;
+    config->min_frame_gap_us = 1000;
+    config->keepalive_ms = 100;
     config->controller_deadzone = 10;
+    config->report_interval_ms = 1;
+    config->event_reporting = true;
+    config->tap_hold_reports = 1;
+    config->keyframe_interval = LINK_DELTA_KEYFRAME_DEFAULT;
+    config->controllers = 1;
+    config->enable_rumble = true;
+    config->rumble_device[0] = '\0';
     config->bindings = NULL;
     config->binding_count = 0;
     config->controller_bindings = NULL;
@@ -123,6 +134,8 @@ bool config_load(config_t *config, const char *filename) {
                 config->serial_port[MAX_PATH_LEN - 1] = '\0';
             } else if (strcmp(key, "baud_rate") == 0) {
                 config->baud_rate = atoi(value);
+            } else if (strcmp(key, "mode") == 0) {
+                config->direct_link = (strcmp(value, "direct") == 0);
             }
         } else if (strcmp(section, "General") == 0) {
             if (strcmp(key, "enable_keyboard") == 0) {
@@ -131,8 +144,37 @@ bool config_load(config_t *config, const char *filename) {
                 config->enable_controller = (strcmp(value, "true") == 0);
             } else if (strcmp(key, "update_rate_hz") == 0) {
                 config->update_rate_hz = atoi(value);
+                if (config->update_rate_hz < 1) config->update_rate_hz = 1;
+            } else if (strcmp(key, "pacing_spin_us") == 0) {
+                config->pacing_spin_us = atoi(value);
+                if (config->pacing_spin_us < 0) config->pacing_spin_us = 0;
+            } else if (strcmp(key, "min_frame_gap_us") == 0) {
+                config->min_frame_gap_us = atoi(value);
+                if (config->min_frame_gap_us < 0) config->min_frame_gap_us = 0;
+            } else if (strcmp(key, "keepalive_ms") == 0) {
+                config->keepalive_ms = atoi(value);
+                if (config->keepalive_ms < 0) config->keepalive_ms = 0;
             } else if (strcmp(key, "controller_deadzone") == 0) {
                 config->controller_deadzone = atoi(value);
+            } else if (strcmp(key, "report_interval_ms") == 0) {
+                config->report_interval_ms = atoi(value);
+            } else if (strcmp(key, "event_reporting") == 0) {
+                config->event_reporting = (strcmp(value, "true") == 0);
+            } else if (strcmp(key, "tap_hold_reports") == 0) {
+                config->tap_hold_reports = atoi(value);
+            } else if (strcmp(key, "keyframe_interval") == 0) {
+                config->keyframe_interval = atoi(value);
+                if (config->keyframe_interval < 1) config->keyframe_interval = 1;
+                if (config->keyframe_interval > 65535) config->keyframe_interval = 65535;
+            } else if (strcmp(key, "controllers") == 0) {
+                config->controllers = atoi(value);
+                if (config->controllers < 1) config->controllers = 1;
+                if (config->controllers > LINK_MAX_CONTROLLERS) config->controllers = LINK_MAX_CONTROLLERS;
+            } else if (strcmp(key, "enable_rumble") == 0) {
+                config->enable_rumble = (strcmp(value, "true") == 0);
+            } else if (strcmp(key, "rumble_device") == 0) {
+                strncpy(config->rumble_device, value, MAX_PATH_LEN - 1);
+                config->rumble_device[MAX_PATH_LEN - 1] = '\0';
             }
         } else if (strcmp(section, "KeyBindings") == 0) {
             /* Parse binding: type:value */
@@ -185,6 +227,13 @@ bool config_load(config_t *config, const char *filename) {
                 if (binding->value.direction != DIR_NONE) {
                     config->binding_count++;
                 }
+            } else if (strcmp(type_str, "macro") == 0) {
+                binding->type = INPUT_TYPE_MACRO;
+                int slot = atoi(value_str);
+                if (slot >= 0 && slot < LINK_MACRO_SLOTS) {
+                    binding->value.macro_slot = (uint8_t)slot;
+                    config->binding_count++;
+                }
             }
         } else if (strcmp(section, "ControllerBindings") == 0) {
             /* Parse controller button binding: button_index = switch_button_name */
@@ -268,13 +317,23 @@ bool config_create_default(const char *filename) {
     
     fprintf(file, "[Serial]\n");
     fprintf(file, "port = COM3\n");
-    fprintf(file, "baud_rate = 115200\n\n");
+    fprintf(file, "baud_rate = 115200\n");
+    fprintf(file, "mode = bridge\n\n");
     
     fprintf(file, "[General]\n");
     fprintf(file, "enable_keyboard = true\n");
     fprintf(file, "enable_controller = true\n");
     fprintf(file, "update_rate_hz = 1000\n");
-    fprintf(file, "controller_deadzone = 10\n\n");
+    fprintf(file, "pacing_spin_us = 0\n");
+    fprintf(file, "min_frame_gap_us = 1000\n");
+    fprintf(file, "keepalive_ms = 100\n");
+    fprintf(file, "controller_deadzone = 10\n");
+    fprintf(file, "report_interval_ms = 1\n");
+    fprintf(file, "event_reporting = true\n");
+    fprintf(file, "tap_hold_reports = 1\n");
+    fprintf(file, "keyframe_interval = 100\n");
+    fprintf(file, "controllers = 1\n");
+    fprintf(file, "enable_rumble = true\n\n");
     
     fprintf(file, "[KeyBindings]\n");
     fprintf(file, "# Face buttons\n");
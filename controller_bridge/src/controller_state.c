@@ -99,33 +99,48 @@ uint8_t apply_stick_calibration(int raw_value, const stick_calibration_t *cal, b
     return (uint8_t)calibrated;
 }
 
-void controller_state_to_packet(const controller_state_t *state, uint8_t *packet) {
-    /* Build 10-byte packet: 0xAA 0x55 header + 8 data bytes */
-    /* This matches what the s2rc receiver expects */
+void controller_state_to_payload(const controller_state_t *state, uint8_t *payload) {
+    /* The LINK_STATE_SIZE bytes of a LINK_TYPE_STATE frame */
     
-    /* Header bytes for packet synchronization */
-    packet[0] = 0xAA;
-    packet[1] = 0x55;
+    /* Bytes 0-1: Buttons (little endian uint16_t) */
+    payload[0] = (uint8_t)(state->buttons & 0xFF);
+    payload[1] = (uint8_t)((state->buttons >> 8) & 0xFF);
     
-    /* Bytes 2-3: Buttons (little endian uint16_t) */
-    packet[2] = (uint8_t)(state->buttons & 0xFF);
-    packet[3] = (uint8_t)((state->buttons >> 8) & 0xFF);
+    /* Byte 2: D-Pad HAT */
+    payload[2] = controller_state_get_hat(state);
     
-    /* Byte 4: D-Pad HAT */
-    packet[4] = controller_state_get_hat(state);
+    /* Byte 3: Left Stick X */
+    payload[3] = state->lx;
     
-    /* Byte 5: Left Stick X */
-    packet[5] = state->lx;
+    /* Byte 4: Left Stick Y */
+    payload[4] = state->ly;
     
-    /* Byte 6: Left Stick Y */
-    packet[6] = state->ly;
+    /* Byte 5: Right Stick X */
+    payload[5] = state->rx;
     
-    /* Byte 7: Right Stick X */
-    packet[7] = state->rx;
+    /* Byte 6: Right Stick Y */
+    payload[6] = state->ry;
     
-    /* Byte 8: Right Stick Y */
-    packet[8] = state->ry;
+    /* Byte 7: Vendor byte (always 0) */
+    payload[7] = 0x00;
+}
+
+size_t controller_state_to_packet(const controller_state_t *state, link_encoder_t *link,
+                                  link_delta_t *delta, uint8_t *packet) {
+    /* Build a LINK_TYPE_STATE keyframe or a LINK_TYPE_DELTA frame with only
+     * the bytes that changed (see link_protocol.h); packet must hold
+     * LINK_ENCODED_SIZE(LINK_DELTA_MAX_SIZE) bytes */
+    uint8_t payload[LINK_STATE_SIZE];
+    controller_state_to_payload(state, payload);
     
-    /* Byte 9: Vendor byte (always 0) */
-    packet[9] = 0x00;
+    uint8_t type;
+    uint8_t frame[LINK_DELTA_MAX_SIZE];
+    size_t len = link_delta_encode(delta, payload, &type, frame);
+    return link_encode(link, type, frame, len, packet);
+}
+
+size_t link_command_to_packet(link_encoder_t *link, uint8_t command, uint8_t value, uint8_t *packet) {
+    /* Build a LINK_TYPE_COMMAND frame: command + value */
+    uint8_t payload[2] = { command, value };
+    return link_encode(link, LINK_TYPE_COMMAND, payload, sizeof(payload), packet);
 }
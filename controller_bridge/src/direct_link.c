@@ -0,0 +1,72 @@
+#include "controller_bridge.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Replies come back through the adapter's USB latency and the OS, often
+ * several ms each way, so the Pico-to-Pico timeouts are too tight here */
+#define DIRECT_ACK_TIMEOUT_MS   150
+#define DIRECT_PROBE_TIMEOUT_MS 100
+
+static uint32_t now_ms(void) {
+    return (uint32_t)(timing_now_us() / 1000);
+}
+
+static void direct_set_baud(void *ctx, uint32_t baud) {
+    direct_link_t *direct = (direct_link_t *)ctx;
+    
+    /* The switch request must go out at the old rate */
+    serial_writer_flush(direct->writer);
+    if (!serial_set_baud(direct->serial, (int)baud)) {
+        /* The probes at this rate fail and the master moves on */
+        fprintf(stderr, "Warning: Adapter does not take %lu baud\n", (unsigned long)baud);
+    }
+    direct->rate_changed = true;
+}
+
+static void direct_send(void *ctx, uint8_t type, const uint8_t *payload, size_t len) {
+    direct_link_t *direct = (direct_link_t *)ctx;
+    serial_writer_post(direct->writer, type, payload, len);
+}
+
+void direct_link_init(direct_link_t *direct, serial_port_t serial, serial_writer_t *writer) {
+    memset(direct, 0, sizeof(*direct));
+    direct->serial = serial;
+    direct->writer = writer;
+    
+    const link_baud_ops_t ops = {
+        .set_baud = direct_set_baud,
+        .send = direct_send,
+        .ctx = direct,
+    };
+    link_baud_master_init(&direct->master, &ops, now_ms());
+    link_baud_master_set_timeouts(&direct->master, DIRECT_ACK_TIMEOUT_MS, DIRECT_PROBE_TIMEOUT_MS);
+    direct->reported_baud = 0;  /* Report the first outcome, even the base rate */
+}
+
+bool direct_link_poll(direct_link_t *direct, const link_rx_stats_t *rx_stats) {
+    link_baud_master_poll(&direct->master, now_ms(), rx_stats);
+    
+    if (direct->master.state == LINK_BAUD_RUNNING && direct->master.baud != direct->reported_baud) {
+        if (direct->master.baud == LINK_BAUD_BASE) {
+            printf("\nLink to the Switch Pico: no faster rate passed the probe, running at "
+                   "%lu baud and retrying\n", (unsigned long)direct->master.baud);
+        } else {
+            printf("\nLink to the Switch Pico: %lu baud\n", (unsigned long)direct->master.baud);
+        }
+        direct->reported_baud = direct->master.baud;
+    }
+    
+    bool changed = direct->rate_changed;
+    direct->rate_changed = false;
+    return changed;
+}
+
+uint64_t direct_link_due_us(const direct_link_t *direct) {
+    uint64_t now_us = timing_now_us();
+    int32_t left_ms = (int32_t)(direct->master.deadline_ms - (uint32_t)(now_us / 1000));
+    return left_ms > 0 ? now_us + (uint64_t)left_ms * 1000 : now_us;
+}
+
+bool direct_link_handle_frame(direct_link_t *direct, const link_frame_t *frame) {
+    return link_baud_master_handle_frame(&direct->master, frame, now_ms());
+}
@@ -0,0 +1,78 @@
+#include "controller_bridge.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Acks older than this are assumed to belong to a previous lap of the
+ * 8-bit sequence number. A lap is 256 frames: about 280 ms at 115200 baud
+ * and 1 kHz, much less on a faster direct link, so stay well below it. */
+#define LATENCY_MAX_RTT_US 50000
+
+void latency_init(latency_tracker_t *tracker) {
+    memset(tracker, 0, sizeof(*tracker));
+}
+
+void latency_on_ack(latency_tracker_t *tracker, const link_ack_t *ack, uint64_t sent_us,
+                    uint64_t now_us) {
+    tracker->acks++;
+    
+    /* Time the frame spent on the Switch Pico before a report carried it.
+     * Both timestamps come from the Pico clock, so only the difference is
+     * usable here. */
+    uint32_t device_us = ack->report_us - ack->rx_us;
+    
+    if (sent_us == 0 || now_us < sent_us || now_us - sent_us > LATENCY_MAX_RTT_US ||
+        now_us - sent_us < device_us) {
+        tracker->unmatched_acks++;
+        return;
+    }
+    
+    /* The clocks are not synchronised: assume the way down (PC -> bridge ->
+     * Switch Pico) takes as long as the way back and split the rest of the
+     * round trip evenly. */
+    uint32_t rtt_us = (uint32_t)(now_us - sent_us);
+    uint32_t transit_us = (rtt_us - device_us) / 2;
+    
+    latency_sample_t *sample = &tracker->samples[tracker->next];
+    sample->rtt_us = rtt_us;
+    sample->one_way_us = transit_us + device_us;
+    
+    tracker->next = (tracker->next + 1) % LATENCY_MAX_SAMPLES;
+    if (tracker->count < LATENCY_MAX_SAMPLES) {
+        tracker->count++;
+    }
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentile(uint32_t *sorted, size_t count, int pct) {
+    size_t index = (count * (size_t)pct) / 100;
+    if (index >= count) index = count - 1;
+    return sorted[index];
+}
+
+bool latency_get_summary(const latency_tracker_t *tracker, latency_summary_t *summary) {
+    static uint32_t values[LATENCY_MAX_SAMPLES];
+    size_t count = tracker->count;
+    
+    memset(summary, 0, sizeof(*summary));
+    if (count == 0) {
+        return false;
+    }
+    summary->samples = count;
+    
+    for (size_t i = 0; i < count; i++) values[i] = tracker->samples[i].rtt_us;
+    qsort(values, count, sizeof(values[0]), compare_u32);
+    summary->rtt_p50_us = percentile(values, count, 50);
+    summary->rtt_p99_us = percentile(values, count, 99);
+    
+    for (size_t i = 0; i < count; i++) values[i] = tracker->samples[i].one_way_us;
+    qsort(values, count, sizeof(values[0]), compare_u32);
+    summary->one_way_p50_us = percentile(values, count, 50);
+    summary->one_way_p99_us = percentile(values, count, 99);
+    
+    return true;
+}
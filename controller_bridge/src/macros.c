@@ -0,0 +1,294 @@
+#include "controller_bridge.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/* Erasing the flash sector takes ~50 ms on the Switch Pico */
+#define MACRO_REPLY_TIMEOUT_US 1000000
+#define MACRO_RETRIES          3
+
+typedef struct {
+    uint8_t data[LINK_MACRO_IMAGE_MAX];
+    size_t len;
+    int loop_depth;
+    bool in_macro;
+} macro_image_t;
+
+static bool emit(macro_image_t *image, const uint8_t *bytes, size_t count) {
+    if (image->len + count > sizeof(image->data)) {
+        return false;
+    }
+    memcpy(&image->data[image->len], bytes, count);
+    image->len += count;
+    return true;
+}
+
+/* Buttons joined with '+' or separated by spaces, e.g. "A+B" or "A B" */
+static bool parse_buttons(char *args, uint16_t *mask) {
+    *mask = 0;
+    for (char *name = strtok(args, " \t+"); name; name = strtok(NULL, " \t+")) {
+        for (char *c = name; *c; c++) *c = (char)toupper((unsigned char)*c);
+        uint16_t button = parse_button_name(name);
+        if (button == 0) {
+            return false;
+        }
+        *mask |= button;
+    }
+    return *mask != 0;
+}
+
+static bool parse_number(const char *args, long min, long max, long *value) {
+    char *end;
+    *value = strtol(args, &end, 0);
+    while (isspace((unsigned char)*end)) end++;
+    return end != args && *end == '\0' && *value >= min && *value <= max;
+}
+
+static bool end_macro(macro_image_t *image) {
+    uint8_t op = LINK_MACRO_OP_END;
+    if (!image->in_macro) {
+        return true;
+    }
+    image->in_macro = false;
+    return image->loop_depth == 0 && emit(image, &op, 1);
+}
+
+/* One instruction per line (see README); '#' starts a comment:
+ *
+ *   macro <slot>            start of a macro
+ *   press <buttons>         release <buttons>
+ *   hold <reports>          wait <ms>
+ *   loop [count]            next
+ *   turbo <buttons> [reports]
+ *   end
+ */
+static bool assemble_line(macro_image_t *image, char *line) {
+    static char no_args[] = "";
+    char *op = strtok(line, " \t");
+    char *args = strtok(NULL, "");
+    long value;
+    uint16_t mask;
+
+    if (!args) args = no_args;
+    while (isspace((unsigned char)*args)) args++;
+
+    if (strcmp(op, "macro") == 0) {
+        if (!end_macro(image) || !parse_number(args, 0, LINK_MACRO_SLOTS - 1, &value)) {
+            return false;
+        }
+        uint8_t *slot = &image->data[8 + 2 * value];
+        if ((slot[0] | (slot[1] << 8)) != LINK_MACRO_NO_SLOT) {
+            return false;  /* Defined twice */
+        }
+        slot[0] = (uint8_t)(image->len & 0xFF);
+        slot[1] = (uint8_t)(image->len >> 8);
+        image->in_macro = true;
+        return true;
+    }
+
+    if (!image->in_macro) {
+        return false;
+    }
+
+    if (strcmp(op, "press") == 0 || strcmp(op, "release") == 0) {
+        if (!parse_buttons(args, &mask)) {
+            return false;
+        }
+        uint8_t bytes[3] = { strcmp(op, "press") == 0 ? LINK_MACRO_OP_PRESS : LINK_MACRO_OP_RELEASE,
+                             (uint8_t)(mask & 0xFF), (uint8_t)(mask >> 8) };
+        return emit(image, bytes, sizeof(bytes));
+    }
+    if (strcmp(op, "hold") == 0) {
+        if (!parse_number(args, 1, 255, &value)) {
+            return false;
+        }
+        uint8_t bytes[2] = { LINK_MACRO_OP_HOLD, (uint8_t)value };
+        return emit(image, bytes, sizeof(bytes));
+    }
+    if (strcmp(op, "wait") == 0) {
+        if (!parse_number(args, 1, 65535, &value)) {
+            return false;
+        }
+        uint8_t bytes[3] = { LINK_MACRO_OP_WAIT, (uint8_t)(value & 0xFF), (uint8_t)(value >> 8) };
+        return emit(image, bytes, sizeof(bytes));
+    }
+    if (strcmp(op, "loop") == 0) {
+        value = 0;  /* Forever */
+        if ((*args && !parse_number(args, 0, 255, &value)) ||
+            ++image->loop_depth > LINK_MACRO_MAX_DEPTH) {
+            return false;
+        }
+        uint8_t bytes[2] = { LINK_MACRO_OP_LOOP, (uint8_t)value };
+        return emit(image, bytes, sizeof(bytes));
+    }
+    if (strcmp(op, "next") == 0) {
+        uint8_t byte = LINK_MACRO_OP_NEXT;
+        return *args == '\0' && image->loop_depth-- > 0 && emit(image, &byte, 1);
+    }
+    if (strcmp(op, "turbo") == 0) {
+        /* Optional trailing period in reports, default 1 */
+        value = 1;
+        char *last = strrchr(args, ' ');
+        if (last && isdigit((unsigned char)last[1])) {
+            if (!parse_number(last + 1, 1, 255, &value)) {
+                return false;
+            }
+            *last = '\0';
+        }
+        if (!parse_buttons(args, &mask)) {
+            return false;
+        }
+        uint8_t bytes[4] = { LINK_MACRO_OP_TURBO, (uint8_t)(mask & 0xFF), (uint8_t)(mask >> 8),
+                             (uint8_t)value };
+        return emit(image, bytes, sizeof(bytes));
+    }
+    if (strcmp(op, "end") == 0) {
+        return *args == '\0' && end_macro(image);
+    }
+    return false;
+}
+
+static bool assemble(const char *filename, macro_image_t *image) {
+    FILE *f = fopen(filename, "r");
+    if (!f) {
+        fprintf(stderr, "Error: Could not open macro file: %s\n", filename);
+        return false;
+    }
+
+    memset(image, 0, sizeof(*image));
+    memset(&image->data[8], 0xFF, 2 * LINK_MACRO_SLOTS);
+    image->len = LINK_MACRO_HEADER_SIZE;
+
+    char line[256];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_number++;
+        line[strcspn(line, "#\r\n")] = '\0';
+
+        char *start = line;
+        while (isspace((unsigned char)*start)) start++;
+        if (*start == '\0') {
+            continue;
+        }
+        if (!assemble_line(image, start)) {
+            fprintf(stderr, "Error: %s:%d: invalid or misplaced instruction\n",
+                    filename, line_number);
+            fclose(f);
+            return false;
+        }
+    }
+    fclose(f);
+
+    if (!end_macro(image)) {
+        fprintf(stderr, "Error: %s: loop without next, or macros too large\n", filename);
+        return false;
+    }
+
+    link_put_u32(image->data, LINK_MACRO_MAGIC);
+    image->data[4] = (uint8_t)(image->len & 0xFF);
+    image->data[5] = (uint8_t)(image->len >> 8);
+    uint16_t crc = link_crc16(&image->data[LINK_MACRO_HEADER_SIZE],
+                              image->len - LINK_MACRO_HEADER_SIZE);
+    image->data[6] = (uint8_t)(crc & 0xFF);
+    image->data[7] = (uint8_t)(crc >> 8);
+    return true;
+}
+
+typedef struct {
+    uint8_t op;
+    bool answered;
+    uint8_t status;
+} macro_reply_t;
+
+static void handle_macro_reply(const link_frame_t *frame, void *ctx) {
+    macro_reply_t *reply = (macro_reply_t *)ctx;
+
+    if (frame->type == LINK_TYPE_MACRO && frame->len >= 2 && frame->payload[0] == reply->op) {
+        reply->status = frame->payload[1];
+        reply->answered = true;
+    }
+}
+
+/* Send one upload request and wait for its status; retried if unanswered */
+static bool request(serial_port_t serial, link_encoder_t *link, link_decoder_t *decoder,
+                    const uint8_t *payload, size_t len) {
+    uint8_t packet[LINK_MAX_ENCODED];
+
+    for (int attempt = 0; attempt < MACRO_RETRIES; attempt++) {
+        macro_reply_t reply = { .op = payload[0], .answered = false };
+        size_t packet_len = link_encode(link, LINK_TYPE_MACRO, payload, len, packet);
+        if (!serial_write(serial, packet, packet_len)) {
+            return false;
+        }
+
+        uint64_t sent_us = timing_now_us();
+        while (!reply.answered && timing_now_us() - sent_us < MACRO_REPLY_TIMEOUT_US) {
+            uint8_t buffer[256];
+            int count = serial_read(serial, buffer, sizeof(buffer));
+            if (count > 0) {
+                link_decoder_feed(decoder, buffer, (size_t)count, handle_macro_reply, &reply);
+            } else {
+                timing_sleep_ms(1);
+            }
+        }
+
+        if (reply.answered) {
+            if (reply.status != LINK_MACRO_STATUS_OK) {
+                fprintf(stderr, "Error: Switch Pico rejected macro upload (op %u, status %u)\n",
+                        payload[0], reply.status);
+                return false;
+            }
+            return true;
+        }
+    }
+
+    fprintf(stderr, "Error: No reply from the Switch Pico\n");
+    return false;
+}
+
+bool macros_upload(serial_port_t serial, link_encoder_t *link, const char *filename) {
+    static macro_image_t image;
+    if (!assemble(filename, &image)) {
+        return false;
+    }
+
+    link_decoder_t decoder;
+    link_decoder_init(&decoder);
+
+    uint8_t payload[3 + LINK_MACRO_CHUNK_MAX];
+    payload[0] = LINK_MACRO_UPLOAD_BEGIN;
+    payload[1] = (uint8_t)(image.len & 0xFF);
+    payload[2] = (uint8_t)(image.len >> 8);
+    if (!request(serial, link, &decoder, payload, 3)) {
+        return false;
+    }
+
+    for (size_t offset = 0; offset < image.len; offset += LINK_MACRO_CHUNK_MAX) {
+        size_t count = image.len - offset;
+        if (count > LINK_MACRO_CHUNK_MAX) count = LINK_MACRO_CHUNK_MAX;
+
+        payload[0] = LINK_MACRO_UPLOAD_DATA;
+        payload[1] = (uint8_t)(offset & 0xFF);
+        payload[2] = (uint8_t)(offset >> 8);
+        memcpy(&payload[3], &image.data[offset], count);
+        if (!request(serial, link, &decoder, payload, 3 + count)) {
+            return false;
+        }
+    }
+
+    payload[0] = LINK_MACRO_UPLOAD_COMMIT;
+    if (!request(serial, link, &decoder, payload, 1)) {
+        return false;
+    }
+
+    int macros = 0;
+    for (int slot = 0; slot < LINK_MACRO_SLOTS; slot++) {
+        if ((image.data[8 + 2 * slot] | (image.data[9 + 2 * slot] << 8)) != LINK_MACRO_NO_SLOT) {
+            macros++;
+        }
+    }
+    printf("Stored %d macro%s (%zu bytes) on the Switch Pico\n", macros,
+           macros == 1 ? "" : "s", image.len);
+    return true;
+}
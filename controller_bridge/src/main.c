@@ -18,11 +18,15 @@
 
 static volatile bool g_running = true;
 
+/* Latency, pacing and writer summaries */
+#define LATENCY_REPORT_US 10000000ULL
+
 /* Global raw stick values for calibration (populated by platform code) */
 int g_raw_lx = 128;
 int g_raw_ly = 128;
 int g_raw_rx = 128;
 int g_raw_ry = 128;
+int g_raw_button = -1;
 
 void signal_handler(int signum) {
     (void)signum;
@@ -118,8 +122,10 @@ int detect_controller_button_press(int timeout_ms) {
     
     controller_state_init(&prev_state);
     platform_input_poll(&prev_state, &temp_config);
+    g_raw_button = -1;
     
     int detected_button = -1;
+    bool detected_raw = false;
     int elapsed = 0;
     
     /* Phase 1: Wait for button press */
@@ -130,6 +136,13 @@ int detect_controller_button_press(int timeout_ms) {
         controller_state_init(&curr_state);
         platform_input_poll(&curr_state, &temp_config);
         
+        /* Platforms that number buttons themselves report the index */
+        if (g_raw_button >= 0) {
+            detected_button = g_raw_button;
+            detected_raw = true;
+            break;
+        }
+        
         /* Check for button press (new buttons that weren't pressed before) */
         uint16_t new_buttons = curr_state.buttons & ~prev_state.buttons;
         
@@ -152,8 +165,8 @@ int detect_controller_button_press(int timeout_ms) {
         return -1;
     }
     
-    /* Phase 2: Wait for button release */
-    uint16_t button_mask = (1 << detected_button);
+    /* Phase 2: Wait for button release (any button, for a raw index) */
+    uint16_t button_mask = detected_raw ? 0xFFFF : (1 << detected_button);
     while (elapsed < timeout_ms) {
         SLEEP_MS(50);
         elapsed += 50;
@@ -620,14 +633,130 @@ void print_banner(void) {
 
 void print_config_info(const config_t *config) {
     printf("Configuration:\n");
-    printf("  Serial Port:      %s @ %d baud\n", config->serial_port, config->baud_rate);
+    if (config->direct_link) {
+        printf("  Serial Port:      %s (direct to the Switch Pico, rate negotiated)\n",
+               config->serial_port);
+    } else {
+        printf("  Serial Port:      %s @ %d baud\n", config->serial_port, config->baud_rate);
+    }
     printf("  Keyboard Input:   %s\n", config->enable_keyboard ? "Enabled" : "Disabled");
     printf("  Controller Input: %s\n", config->enable_controller ? "Enabled" : "Disabled");
-    printf("  Update Rate:      %d Hz\n", config->update_rate_hz);
+    if (EVENT_LOOP_WAKES_ON_INPUT) {
+        printf("  Input Polling:    none (woken by input)\n");
+    } else {
+        printf("  Input Polling:    %d Hz", config->update_rate_hz);
+        if (config->pacing_spin_us > 0) {
+            printf(" (spin %d us)", config->pacing_spin_us);
+        }
+        printf("\n");
+    }
+    printf("  Sending:          on change, %d us apart", config->min_frame_gap_us);
+    if (config->keepalive_ms > 0) {
+        printf(", keepalive every %d ms", config->keepalive_ms);
+    }
+    printf("\n");
+    printf("  Switch Reports:   every %d ms%s\n", config->report_interval_ms,
+           config->event_reporting ? ", immediately on change" : "");
+    printf("  Tap Hold:         %d report%s\n", config->tap_hold_reports,
+           config->tap_hold_reports == 1 ? "" : "s");
+    printf("  Keyframes:        every %d frames\n", config->keyframe_interval);
+    printf("  Controllers:      %d\n", config->controllers);
+    printf("  Rumble:           %s\n", config->enable_rumble ? "Enabled" : "Disabled");
     printf("  Loaded Bindings:  %d key mappings\n", config->binding_count);
     printf("\n");
 }
 
+void print_latency_summary(const latency_tracker_t *latency) {
+    latency_summary_t summary;
+    if (!latency_get_summary(latency, &summary)) {
+        return;
+    }
+    printf("\n[Latency] %zu samples  one-way p50 %.2f ms  p99 %.2f ms  "
+           "round-trip p50 %.2f ms  p99 %.2f ms  (unmatched acks: %lu)\n",
+           summary.samples,
+           summary.one_way_p50_us / 1000.0, summary.one_way_p99_us / 1000.0,
+           summary.rtt_p50_us / 1000.0, summary.rtt_p99_us / 1000.0,
+           latency->unmatched_acks);
+}
+
+void print_writer_summary(serial_writer_t *writer) {
+    serial_writer_stats_t stats;
+    serial_writer_get_stats(writer, &stats);
+    if (stats.frames == 0 && stats.failures == 0) {
+        return;
+    }
+    printf("[Serial] %lu frames written  longest write %.2f ms  post to written %.2f ms  "
+           "(superseded: %lu, stalls: %lu, failures: %lu)\n",
+           stats.frames, stats.max_write_us / 1000.0, stats.max_queued_us / 1000.0,
+           stats.superseded, stats.stalls, stats.failures);
+}
+
+void print_pacer_summary(pacer_t *pacer) {
+    pacer_summary_t summary;
+    if (!pacer_get_summary(pacer, &summary, timing_now_us())) {
+        return;
+    }
+    printf("[Polling] %.1f Hz (target %d)  jitter p50 %.3f ms  p99 %.3f ms  max %.3f ms  "
+           "(missed deadlines: %lu)\n",
+           summary.rate_hz, summary.target_hz,
+           summary.jitter_p50_us / 1000.0, summary.jitter_p99_us / 1000.0,
+           summary.jitter_max_us / 1000.0, summary.missed);
+}
+
+/* Frames coming back from the Switch Pico during normal operation (relayed
+ * by the bridge Pico, or straight from it in direct mode) */
+typedef struct {
+    latency_tracker_t *latency;
+    serial_writer_t *writer;      /* Knows when each acked frame went out */
+    output_tracker_t *output;
+    direct_link_t *direct;        /* NULL with a bridge Pico */
+} upstream_t;
+
+static void handle_upstream_frame(const link_frame_t *frame, void *ctx) {
+    upstream_t *upstream = (upstream_t *)ctx;
+    link_ack_t ack;
+    
+    if (upstream->direct && direct_link_handle_frame(upstream->direct, frame)) {
+        return;
+    }
+    if (frame->type == LINK_TYPE_ACK && link_ack_unpack(frame->payload, frame->len, &ack)) {
+        latency_on_ack(upstream->latency, &ack,
+                       serial_writer_take_sent_us(upstream->writer, ack.seq), timing_now_us());
+    } else {
+        output_on_frame(upstream->output, frame, timing_now_us());
+    }
+}
+
+static void poll_upstream(serial_port_t serial, link_decoder_t *decoder, upstream_t *upstream) {
+    uint8_t buffer[256];
+    int count;
+    
+    while ((count = serial_read(serial, buffer, sizeof(buffer))) > 0) {
+        link_decoder_feed(decoder, buffer, (size_t)count, handle_upstream_frame, upstream);
+    }
+}
+
+/* Pass rumble on to the local gamepad right away, and show what the console
+ * sends (rumble, LEDs) whenever it changes */
+static void handle_output_event(const output_event_t *event, void *ctx) {
+    const config_t *config = (const config_t *)ctx;
+    rumble_t rumble;
+    
+    if (!event->changed) {
+        return;
+    }
+    if (config->enable_rumble && rumble_from_output(&event->report, &rumble)) {
+        platform_rumble(event->report.controller, &rumble, config);
+    }
+    
+    printf("\n[Output] Controller %d, report %u:", event->report.controller + 1,
+           event->report.report_id);
+    for (int i = 0; i < event->report.len; i++) {
+        printf(" %02X", event->report.data[i]);
+    }
+    printf("\n");
+}
+
 void print_controls(void) {
     printf("Default Controls:\n");
     printf("  D-Pad:        Arrow Keys\n");
@@ -644,6 +773,9 @@ int main(int argc, char *argv[]) {
     config_t config;
     char config_filename[256] = "controller_bridge.ini";
     bool run_wizard = false;
+    const char *timeline_filename = NULL;
+    const char *macro_filename = NULL;
+    bool show_stats = false;
     
     print_banner();
     
@@ -654,16 +786,39 @@ int main(int argc, char *argv[]) {
             printf("Options:\n");
             printf("  --help, -h          Show this help message\n");
             printf("  --setup             Run interactive setup wizard\n");
+            printf("  --play <file>       Play a timeline file with report-exact timing, then exit\n");
+            printf("  --macros <file>     Store the macros in <file> on the Switch Pico, then exit\n");
+            printf("  --stats             Print the performance counters of both Picos, then exit\n");
             printf("  [config_file]       Use specified config file (default: controller_bridge.ini)\n");
             printf("\n");
             printf("Examples:\n");
             printf("  %s                              # Interactive prompt\n", argv[0]);
             printf("  %s --setup                      # Run setup wizard\n", argv[0]);
             printf("  %s custom_config.ini            # Use custom config\n", argv[0]);
+            printf("  %s --play combo.txt             # Play a timeline\n", argv[0]);
+            printf("  %s --macros macros.txt          # Upload macros\n", argv[0]);
+            printf("  %s --stats                      # Diagnose jitter\n", argv[0]);
             printf("\n");
             return 0;
         } else if (strcmp(argv[1], "--setup") == 0) {
             run_wizard = true;
+        } else if (strcmp(argv[1], "--stats") == 0) {
+            show_stats = true;
+            if (argc > 2) {
+                strncpy(config_filename, argv[2], sizeof(config_filename) - 1);
+                config_filename[sizeof(config_filename) - 1] = '\0';
+            }
+        } else if ((strcmp(argv[1], "--play") == 0 || strcmp(argv[1], "--macros") == 0) &&
+                   argc > 2) {
+            if (strcmp(argv[1], "--play") == 0) {
+                timeline_filename = argv[2];
+            } else {
+                macro_filename = argv[2];
+            }
+            if (argc > 3) {
+                strncpy(config_filename, argv[3], sizeof(config_filename) - 1);
+                config_filename[sizeof(config_filename) - 1] = '\0';
+            }
         } else {
             strncpy(config_filename, argv[1], sizeof(config_filename) - 1);
             config_filename[sizeof(config_filename) - 1] = '\0';
@@ -752,7 +907,9 @@ int main(int argc, char *argv[]) {
     
     /* Open serial port */
     printf("Opening serial port %s...\n", config.serial_port);
-    serial_port_t serial = serial_open(config.serial_port, config.baud_rate);
+    /* Direct mode starts at the Switch Pico's power-up rate */
+    serial_port_t serial = serial_open(config.serial_port,
+                                       config.direct_link ? LINK_BAUD_BASE : config.baud_rate);
     if (!serial || !serial_is_open(serial)) {
         fprintf(stderr, "\nError: Could not open serial port %s\n", config.serial_port);
         fprintf(stderr, "\nTroubleshooting:\n");
@@ -769,6 +926,54 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     printf("Serial port opened successfully!\n\n");
+    if (config.direct_link && !serial_set_low_latency(serial)) {
+        printf("Note: Could not set the adapter to low latency; see README (Direct Mode)\n\n");
+    }
+    
+    /* Link framing state (sequence numbers) shared by every frame we send */
+    link_encoder_t link;
+    link_encoder_init(&link);
+    link_delta_t delta[LINK_MAX_CONTROLLERS];
+    for (int i = 0; i < config.controllers; i++) {
+        link_delta_init(&delta[i], (uint16_t)config.keyframe_interval);
+        delta[i].controller = (uint8_t)i;
+    }
+    
+    uint8_t packet[LINK_MAX_ENCODED];
+    size_t packet_len;
+    
+    if (show_stats) {
+        bool answered = stats_query(serial, &link, config.direct_link);
+        serial_close(serial);
+        config_free(&config);
+        return answered ? 0 : 1;
+    }
+    
+    /* Configure how the Switch Pico schedules its HID reports */
+    packet_len = link_command_to_packet(&link, LINK_CMD_REPORT_INTERVAL,
+                                        (uint8_t)config.report_interval_ms, packet);
+    serial_write(serial, packet, packet_len);
+    packet_len = link_command_to_packet(&link, LINK_CMD_REPORT_MODE,
+                                        config.event_reporting ? 1 : 0, packet);
+    serial_write(serial, packet, packet_len);
+    packet_len = link_command_to_packet(&link, LINK_CMD_TAP_HOLD,
+                                        (uint8_t)config.tap_hold_reports, packet);
+    serial_write(serial, packet, packet_len);
+    
+    if (timeline_filename) {
+        signal(SIGINT, signal_handler);
+        bool played = timeline_play(serial, &link, timeline_filename, &g_running);
+        serial_close(serial);
+        config_free(&config);
+        return played ? 0 : 1;
+    }
+    
+    if (macro_filename) {
+        bool stored = macros_upload(serial, &link, macro_filename);
+        serial_close(serial);
+        config_free(&config);
+        return stored ? 0 : 1;
+    }
     
     /* Initialize controller state */
     controller_state_t state;
@@ -791,76 +996,217 @@ int main(int argc, char *argv[]) {
     signal(SIGTERM, signal_handler);
 #endif
     
-    /* Calculate sleep time for update rate */
-    int sleep_ms = 1000 / config.update_rate_hz;
-    if (sleep_ms < 1) sleep_ms = 1;
+    /* Acks from the Switch Pico, for end-to-end latency, and output reports
+     * the console sent */
+    link_decoder_t upstream;
+    link_decoder_init(&upstream);
+    static latency_tracker_t latency;
+    latency_init(&latency);
+    static output_tracker_t output;
+    output_init(&output, handle_output_event, &config);
+    
+    /* From here on all writes go through the writer thread, which also does
+     * the framing: link is its own until it stops */
+    serial_writer_t *writer = serial_writer_create(serial, &link);
+    if (!writer) {
+        fprintf(stderr, "Error: Could not start the serial writer\n");
+        input_handler_destroy(input);
+        serial_close(serial);
+        config_free(&config);
+        return 1;
+    }
+    upstream_t upstream_ctx = { .latency = &latency, .writer = writer, .output = &output,
+                                .direct = NULL };
+    
+    /* Without a bridge Pico, negotiate the link rate ourselves */
+    static direct_link_t direct;
+    if (config.direct_link) {
+        direct_link_init(&direct, serial, writer);
+        upstream_ctx.direct = &direct;
+    }
+    uint64_t last_latency_report_us = timing_now_us();
+    
+    /* Wake as soon as input or a reply arrives */
+    event_loop_t *events = event_loop_create(serial, &config);
+    if (!events) {
+        fprintf(stderr, "Error: Could not set up the event loop\n");
+        serial_writer_destroy(writer);
+        input_handler_destroy(input);
+        serial_close(serial);
+        config_free(&config);
+        return 1;
+    }
+    /* Only used where input has to be polled; on Linux it stays empty and
+     * prints nothing */
+    static pacer_t pacer;
+    if (!EVENT_LOOP_WAKES_ON_INPUT) {
+        pacer_init(&pacer, config.update_rate_hz, config.pacing_spin_us, timing_now_us());
+    }
+    send_policy_t policy[LINK_MAX_CONTROLLERS];
+    for (int slot = 0; slot < config.controllers; slot++) {
+        send_policy_init(&policy[slot], config.min_frame_gap_us, config.keepalive_ms);
+    }
     
     /* Main loop */
-    uint8_t packet[10];  /* 10-byte packet: 0xAA 0x55 header + 8 data bytes */
     unsigned long packet_count = 0;
+    uint8_t last_macro_key = 0;
     
     printf("Controller bridge active! Waiting for input...\n\n");
     
     while (g_running && input_handler_is_running(input)) {
-        /* Reset state for this frame */
-        controller_state_init(&state);
+        /* Wake for a held-back change, a keepalive, the link negotiation
+         * and the periodic report; where input has to be polled, also on
+         * the pacer's grid. Otherwise idle means asleep. */
+        uint64_t wake_us = last_latency_report_us + LATENCY_REPORT_US;
+        if (!EVENT_LOOP_WAKES_ON_INPUT && pacer_wake_us(&pacer) < wake_us) {
+            wake_us = pacer_wake_us(&pacer);
+        }
+        for (int slot = 0; slot < config.controllers; slot++) {
+            uint64_t due_us = send_policy_due_us(&policy[slot]);
+            if (due_us < wake_us) wake_us = due_us;
+        }
+        if (config.direct_link) {
+            uint64_t due_us = direct_link_due_us(&direct);
+            if (due_us < wake_us) wake_us = due_us;
+        }
+        
+        int ready = event_loop_wait(events, wake_us);
+        if (!EVENT_LOOP_WAKES_ON_INPUT && (ready & EVENT_TIMER) &&
+            timing_now_us() >= pacer_wake_us(&pacer)) {
+            pacer_on_wake(&pacer);
+        }
         
-        /* Poll all input sources */
-        platform_input_poll(&state, &config);
+        /* Replies alone don't send a frame: each frame is acked, and
+         * answering acks with frames would never go quiet */
+        if (ready & (EVENT_INPUT | EVENT_TIMER)) {
+            /* Reset state for this frame */
+            controller_state_init(&state);
         
-        /* Update analog stick positions from directional flags (keyboard input) */
-        /* Only update if controller didn't already set analog values */
-        if (state.lx == STICK_CENTER && state.ly == STICK_CENTER) {
-            /* Left stick at center - apply keyboard directions if any */
-            if (state.lstick_up || state.lstick_down || state.lstick_left || state.lstick_right) {
-                if (state.lstick_up) state.ly = STICK_MIN;
-                else if (state.lstick_down) state.ly = STICK_MAX;
+            /* Poll all input sources */
+            platform_input_poll(&state, &config);
+        
+            /* Update analog stick positions from directional flags (keyboard input) */
+            /* Only update if controller didn't already set analog values */
+            if (state.lx == STICK_CENTER && state.ly == STICK_CENTER) {
+                /* Left stick at center - apply keyboard directions if any */
+                if (state.lstick_up || state.lstick_down || state.lstick_left || state.lstick_right) {
+                    if (state.lstick_up) state.ly = STICK_MIN;
+                    else if (state.lstick_down) state.ly = STICK_MAX;
                 
-                if (state.lstick_left) state.lx = STICK_MIN;
-                else if (state.lstick_right) state.lx = STICK_MAX;
+                    if (state.lstick_left) state.lx = STICK_MIN;
+                    else if (state.lstick_right) state.lx = STICK_MAX;
+                }
             }
-        }
         
-        if (state.rx == STICK_CENTER && state.ry == STICK_CENTER) {
-            /* Right stick at center - apply keyboard directions if any */
-            if (state.rstick_up || state.rstick_down || state.rstick_left || state.rstick_right) {
-                if (state.rstick_up) state.ry = STICK_MIN;
-                else if (state.rstick_down) state.ry = STICK_MAX;
+            if (state.rx == STICK_CENTER && state.ry == STICK_CENTER) {
+                /* Right stick at center - apply keyboard directions if any */
+                if (state.rstick_up || state.rstick_down || state.rstick_left || state.rstick_right) {
+                    if (state.rstick_up) state.ry = STICK_MIN;
+                    else if (state.rstick_down) state.ry = STICK_MAX;
                 
-                if (state.rstick_left) state.rx = STICK_MIN;
-                else if (state.rstick_right) state.rx = STICK_MAX;
+                    if (state.rstick_left) state.rx = STICK_MIN;
+                    else if (state.rstick_right) state.rx = STICK_MAX;
+                }
             }
-        }
         
-        /* Convert state to packet */
-        controller_state_to_packet(&state, packet);
+            /* Start a stored macro when its key goes down */
+            if (state.macro_key != 0 && state.macro_key != last_macro_key) {
+                uint8_t command[2] = { LINK_CMD_MACRO_RUN, (uint8_t)(state.macro_key - 1) };
+                serial_writer_post(writer, LINK_TYPE_COMMAND, command, sizeof(command));
+            }
+            last_macro_key = state.macro_key;
         
-        /* Send packet every cycle (matching Python behavior - 1000Hz continuous sending) */
-        if (serial_write(serial, packet, sizeof(packet))) {
-            packet_count++;
-            
-            /* Print status on button press (not on every packet) */
-            if (state.buttons != 0 && (packet_count % 100 == 0)) {
-                printf("\r[Packets: %lu] Buttons: 0x%04X  ", packet_count, state.buttons);
-                fflush(stdout);
+            /* Send on change or keepalive (see send_policy_t) */
+            uint8_t payload[LINK_STATE_SIZE];
+            uint8_t type;
+            uint8_t frame[LINK_DELTA_MAX_SIZE];
+            size_t frame_len;
+            controller_state_to_payload(&state, payload);
+            send_reason_t reason = send_policy_check(&policy[0], payload, timing_now_us());
+            if (reason != SEND_NONE) {
+                if (reason == SEND_KEEPALIVE || serial_writer_state_pending(writer, 0)) {
+                    link_delta_reset(&delta[0]);
+                }
+                
+                /* A STATE keyframe or a DELTA (see link_protocol.h); the
+                 * writer frames it as it goes out */
+                frame_len = link_delta_encode(&delta[0], payload, &type, frame);
+                
+                uint64_t sent_us = timing_now_us();
+                if (serial_writer_post_state(writer, 0, type, frame, frame_len)) {
+                    send_policy_on_sent(&policy[0], payload, sent_us);
+                    packet_count++;
+                    
+                    /* Print status on button press (not on every packet) */
+                    if (state.buttons != 0 && (packet_count % 100 == 0)) {
+                        printf("\r[Packets: %lu] Buttons: 0x%04X  ", packet_count, state.buttons);
+                        fflush(stdout);
+                    }
+                } else {
+                    fprintf(stderr, "\nWarning: Failed to write to serial port\n");
+                    SLEEP_MS(100);
+                }
+            }
+        
+            /* Further controllers, one gamepad each; a slot without a gamepad
+             * stays neutral */
+            for (int slot = 1; slot < config.controllers; slot++) {
+                controller_state_t pad;
+                controller_state_init(&pad);
+                platform_input_poll_gamepad(slot, &pad, &config);
+                
+                controller_state_to_payload(&pad, payload);
+                reason = send_policy_check(&policy[slot], payload, timing_now_us());
+                if (reason == SEND_NONE) {
+                    continue;
+                }
+                if (reason == SEND_KEEPALIVE || serial_writer_state_pending(writer, slot)) {
+                    link_delta_reset(&delta[slot]);
+                }
+                
+                frame_len = link_delta_encode(&delta[slot], payload, &type, frame);
+                uint64_t sent_us = timing_now_us();
+                if (serial_writer_post_state(writer, slot, type, frame, frame_len)) {
+                    send_policy_on_sent(&policy[slot], payload, sent_us);
+                }
+            }
+        }
+
+        poll_upstream(serial, &upstream, &upstream_ctx);
+        
+        if (config.direct_link && direct_link_poll(&direct, &upstream.stats)) {
+            for (int slot = 0; slot < config.controllers; slot++) {
+                link_delta_reset(&delta[slot]);
+                send_policy_reset(&policy[slot]);
             }
-        } else {
-            fprintf(stderr, "\nWarning: Failed to write to serial port\n");
-            SLEEP_MS(100);
         }
         
-        /* Sleep to maintain update rate */
-        SLEEP_MS(sleep_ms);
+        /* Periodic latency report */
+        if (timing_now_us() - last_latency_report_us >= LATENCY_REPORT_US) {
+            print_latency_summary(&latency);
+            print_pacer_summary(&pacer);
+            print_writer_summary(writer);
+            last_latency_report_us = timing_now_us();
+        }
     }
     
     printf("\n\nShutting down...\n");
+    print_latency_summary(&latency);
+    print_pacer_summary(&pacer);
+    print_writer_summary(writer);
+    serial_writer_destroy(writer);
     
-    /* Send neutral state before exit */
+    /* Send neutral state before exit, as a keyframe so it lands even if the
+     * last delta did not */
     controller_state_init(&state);
-    controller_state_to_packet(&state, packet);
-    serial_write(serial, packet, sizeof(packet));
+    for (int slot = 0; slot < config.controllers; slot++) {
+        link_delta_reset(&delta[slot]);
+        packet_len = controller_state_to_packet(&state, &link, &delta[slot], packet);
+        serial_write(serial, packet, packet_len);
+    }
     
     /* Cleanup */
+    event_loop_destroy(events);
     input_handler_destroy(input);
     serial_close(serial);
     config_free(&config);
@@ -0,0 +1,38 @@
+#include "controller_bridge.h"
+#include <string.h>
+
+void output_init(output_tracker_t *tracker, output_sink_t sink, void *sink_ctx) {
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->sink = sink;
+    tracker->sink_ctx = sink_ctx;
+}
+
+bool output_on_frame(output_tracker_t *tracker, const link_frame_t *frame, uint64_t now_us) {
+    output_event_t event;
+    
+    if (frame->type != LINK_TYPE_OUTPUT) {
+        return false;
+    }
+    if (!link_output_unpack(frame->payload, frame->len, &event.report) ||
+        event.report.controller >= LINK_MAX_CONTROLLERS) {
+        return true;
+    }
+    
+    /* The console repeats the same rumble data while it lasts; sinks that
+     * only care about changes can skip the rest */
+    uint8_t id = event.report.controller;
+    const link_output_t *last = &tracker->last[id].report;
+    event.received_us = now_us;
+    event.changed = !tracker->seen[id] || last->report_id != event.report.report_id ||
+                    last->len != event.report.len ||
+                    memcmp(last->data, event.report.data, event.report.len) != 0;
+    
+    tracker->last[id] = event;
+    tracker->seen[id] = true;
+    tracker->events++;
+    
+    if (tracker->sink) {
+        tracker->sink(&event, tracker->sink_ctx);
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+#include "controller_bridge.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Deadline n is computed from the start rather than by adding a rounded
+ * period each time, so rates that don't divide a second (750 Hz) don't
+ * drift either */
+static uint64_t deadline_at(const pacer_t *pacer, uint64_t tick) {
+    return pacer->start_us + tick * 1000000ULL / (uint64_t)pacer->rate_hz;
+}
+
+void pacer_init(pacer_t *pacer, int rate_hz, int spin_us, uint64_t now_us) {
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->rate_hz = rate_hz > 0 ? rate_hz : 1000;
+    pacer->spin_us = spin_us > 0 ? (uint32_t)spin_us : 0;
+    pacer->start_us = now_us;
+    pacer->window_start_us = now_us;
+    pacer->tick = 1;
+    pacer->deadline_us = deadline_at(pacer, 1);
+}
+
+uint64_t pacer_wake_us(const pacer_t *pacer) {
+    if (pacer->deadline_us > pacer->start_us + pacer->spin_us) {
+        return pacer->deadline_us - pacer->spin_us;
+    }
+    return pacer->deadline_us;
+}
+
+void pacer_on_wake(pacer_t *pacer) {
+    uint64_t now_us = timing_now_us();
+    
+    /* Spin tail: the wakeup was early by spin_us to absorb scheduler latency */
+    while (now_us < pacer->deadline_us) {
+        now_us = timing_now_us();
+    }
+    
+    uint64_t late_us = now_us - pacer->deadline_us;
+    pacer->lateness_us[pacer->next] = late_us > UINT32_MAX ? UINT32_MAX : (uint32_t)late_us;
+    pacer->next = (pacer->next + 1) % PACER_MAX_SAMPLES;
+    if (pacer->count < PACER_MAX_SAMPLES) {
+        pacer->count++;
+    }
+    pacer->window_ticks++;
+    
+    pacer->tick++;
+    pacer->deadline_us = deadline_at(pacer, pacer->tick);
+    
+    /* A whole period or more behind (suspend, slow write): skip the
+     * deadlines that already passed instead of bursting to catch up */
+    if (pacer->deadline_us <= now_us) {
+        uint64_t due = (now_us - pacer->start_us) * (uint64_t)pacer->rate_hz / 1000000ULL + 1;
+        pacer->missed += (unsigned long)(due - pacer->tick);
+        pacer->tick = due;
+        pacer->deadline_us = deadline_at(pacer, due);
+    }
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentile(uint32_t *sorted, size_t count, int pct) {
+    size_t index = (count * (size_t)pct) / 100;
+    if (index >= count) index = count - 1;
+    return sorted[index];
+}
+
+bool pacer_get_summary(pacer_t *pacer, pacer_summary_t *summary, uint64_t now_us) {
+    static uint32_t values[PACER_MAX_SAMPLES];
+    size_t count = pacer->count;
+    
+    memset(summary, 0, sizeof(*summary));
+    if (count == 0 || now_us <= pacer->window_start_us) {
+        return false;
+    }
+    
+    summary->target_hz = pacer->rate_hz;
+    summary->rate_hz = pacer->window_ticks * 1000000.0 / (double)(now_us - pacer->window_start_us);
+    summary->missed = pacer->missed;
+    pacer->window_ticks = 0;
+    pacer->window_start_us = now_us;
+    
+    memcpy(values, pacer->lateness_us, count * sizeof(values[0]));
+    qsort(values, count, sizeof(values[0]), compare_u32);
+    summary->jitter_p50_us = percentile(values, count, 50);
+    summary->jitter_p99_us = percentile(values, count, 99);
+    summary->jitter_max_us = values[count - 1];
+    
+    return true;
+}
@@ -0,0 +1,118 @@
+#if defined(__linux__)
+
+#include "controller_bridge.h"
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+
+/* Keyboard plus one joystick per controller */
+#define MAX_INPUT_FDS (1 + LINK_MAX_CONTROLLERS)
+
+struct event_loop {
+    int epoll_fd;
+    int timer_fd;
+    uint64_t armed_us;   /* Deadline the timerfd is set to, 0 if none */
+};
+
+/* Event data: the EVENT_* flag in the low half, the fd in the high half */
+static bool watch(int epoll_fd, int fd, uint32_t event) {
+    struct epoll_event ev = { .events = EPOLLIN, .data.u64 = ((uint64_t)fd << 32) | event };
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+/* A hung-up fd stays readable for good; stop watching it or every wait
+ * returns at once */
+static void unwatch(event_loop_t *loop, int fd, int event) {
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    if (event == EVENT_INPUT) {
+        platform_input_close_fd(fd);
+    } else if (event == EVENT_SERIAL) {
+        fprintf(stderr, "\nWarning: Serial port hung up\n");
+    }
+}
+
+event_loop_t *event_loop_create(serial_port_t serial, const config_t *config) {
+    event_loop_t *loop = malloc(sizeof(event_loop_t));
+    if (!loop) {
+        return NULL;
+    }
+    loop->armed_us = 0;
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    loop->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (loop->epoll_fd < 0 || loop->timer_fd < 0 ||
+        !watch(loop->epoll_fd, loop->timer_fd, EVENT_TIMER)) {
+        event_loop_destroy(loop);
+        return NULL;
+    }
+
+    /* All level-triggered: the main loop drains every source it wakes for */
+    int serial_fd = serial_get_fd(serial);
+    if (serial_fd >= 0 && !watch(loop->epoll_fd, serial_fd, EVENT_SERIAL)) {
+        event_loop_destroy(loop);
+        return NULL;
+    }
+
+    int fds[MAX_INPUT_FDS];
+    int count = platform_input_get_fds(config, fds, MAX_INPUT_FDS);
+    for (int i = 0; i < count; i++) {
+        if (!watch(loop->epoll_fd, fds[i], EVENT_INPUT)) {
+            event_loop_destroy(loop);
+            return NULL;
+        }
+    }
+
+    return loop;
+}
+
+void event_loop_destroy(event_loop_t *loop) {
+    if (!loop) {
+        return;
+    }
+    if (loop->timer_fd >= 0) close(loop->timer_fd);
+    if (loop->epoll_fd >= 0) close(loop->epoll_fd);
+    free(loop);
+}
+
+int event_loop_wait(event_loop_t *loop, uint64_t deadline_us) {
+    if (timing_now_us() >= deadline_us) {
+        return EVENT_TIMER;
+    }
+
+    /* timerfd on the same clock as timing_now_us, one-shot at the deadline */
+    if (deadline_us != loop->armed_us) {
+        struct itimerspec spec = { 0 };
+        spec.it_value.tv_sec = (time_t)(deadline_us / 1000000ULL);
+        spec.it_value.tv_nsec = (long)(deadline_us % 1000000ULL) * 1000L;
+        timerfd_settime(loop->timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+        loop->armed_us = deadline_us;
+    }
+
+    struct epoll_event events[MAX_INPUT_FDS + 2];
+    int count = epoll_wait(loop->epoll_fd, events, MAX_INPUT_FDS + 2, -1);
+    if (count < 0) {
+        return 0;  /* EINTR: let the caller check its running flag */
+    }
+
+    int ready = 0;
+    for (int i = 0; i < count; i++) {
+        int event = (int)(uint32_t)events[i].data.u64;
+        ready |= event;
+        if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+            unwatch(loop, (int)(events[i].data.u64 >> 32), event);
+        }
+    }
+    if (ready & EVENT_TIMER) {
+        uint64_t expirations;
+        if (read(loop->timer_fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) {
+            ready &= ~EVENT_TIMER;
+        }
+        loop->armed_us = 0;
+    }
+    return ready;
+}
+
+#endif /* __linux__ */
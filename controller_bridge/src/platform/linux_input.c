@@ -1,20 +1,104 @@
 #if defined(__linux__)
 
 #include "controller_bridge.h"
+
+/* <linux/input.h> redefines BTN_A, BTN_B, BTN_X and BTN_Y as key codes;
+ * keep the Switch buttons under other names */
+enum {
+    SWITCH_BTN_A = BTN_A,
+    SWITCH_BTN_B = BTN_B,
+    SWITCH_BTN_X = BTN_X,
+    SWITCH_BTN_Y = BTN_Y
+};
+
 #include <linux/input.h>
-#include <linux/joystick.h>
+#include <sys/ioctl.h>
 #include <fcntl.h>
 #include <unistd.h>
-#include <dirent.h>
+#include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 
-#define MAX_DEVICES 8
+#define MAX_EVENT_DEVICES 64
+
+/* Buttons numbered per pad (index in [ControllerBindings]) */
+#define MAX_PAD_BUTTONS 64
+#define NO_BUTTON 0xFF
 
 static int keyboard_fd = -1;
-static int joystick_fd = -1;
+
+/* Keyboard (slot 0). Events only report changes, so the state is kept here
+ * between polls and copied out. */
+static controller_state_t primary_state;
+
+/* One evdev gamepad per virtual controller slot, in /dev/input/event* order.
+ * Raw button and axis state is kept per pad and turned into a controller
+ * state on every poll. */
+typedef struct {
+    int fd;
+    char path[64];
+    uint8_t button_index[KEY_CNT];       /* Key code -> button index, NO_BUTTON if none */
+    int button_count;
+    uint64_t pressed;                    /* By button index */
+    struct input_absinfo abs[ABS_CNT];   /* value is kept current */
+    bool has_abs[ABS_CNT];
+    int right_x, right_y;                /* Right stick axes */
+    int left_trigger, right_trigger;     /* Analog trigger axes, -1 if none */
+    bool dropped;                        /* SYN_DROPPED: resync at the next SYN_REPORT */
+} evdev_pad_t;
+
+static evdev_pad_t pads[LINK_MAX_CONTROLLERS];
+static int pad_count;
+
+/* Bitmask helpers for EVIOCGBIT and EVIOCGKEY results */
+#define BITS_PER_LONG (8 * sizeof(unsigned long))
+#define NBITS(n) (((n) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+#define TEST_BIT(bit, array) (((array)[(bit) / BITS_PER_LONG] >> ((bit) % BITS_PER_LONG)) & 1UL)
+
+/* Default layout by kernel gamepad code (Documentation/input/gamepad.rst),
+ * positional like the Switch: south is B, east is A */
+typedef struct {
+    uint16_t code;
+    uint16_t mask;
+} pad_button_map_t;
+
+static const pad_button_map_t default_pad_buttons[] = {
+    {BTN_SOUTH, SWITCH_BTN_B}, {BTN_EAST, SWITCH_BTN_A},
+    {BTN_WEST, SWITCH_BTN_Y}, {BTN_NORTH, SWITCH_BTN_X},
+    {BTN_TL, BTN_L}, {BTN_TR, BTN_R}, {BTN_TL2, BTN_ZL}, {BTN_TR2, BTN_ZR},
+    {BTN_SELECT, BTN_MINUS}, {BTN_START, BTN_PLUS},
+    {BTN_THUMBL, BTN_LSTICK}, {BTN_THUMBR, BTN_RSTICK},
+    {BTN_MODE, BTN_HOME}, {BTN_Z, BTN_CAPTURE}, {KEY_RECORD, BTN_CAPTURE},
+    /* Xbox Elite paddles: P1/P2 on the right, P3/P4 on the left */
+    {BTN_TRIGGER_HAPPY5, BTN_GR}, {BTN_TRIGGER_HAPPY6, BTN_GR},
+    {BTN_TRIGGER_HAPPY7, BTN_GL}, {BTN_TRIGGER_HAPPY8, BTN_GL},
+};
+
+#define NUM_DEFAULT_PAD_BUTTONS (sizeof(default_pad_buttons) / sizeof(default_pad_buttons[0]))
+
+/* [ControllerBindings] as button index -> Switch buttons, built for the
+ * config it was last used with */
+static uint16_t binding_masks[MAX_PAD_BUTTONS];
+static const config_t *bound_config;
+
+/* Force feedback per slot. The rumble effect is uploaded once and then
+ * only updated in place (same effect id) when the magnitudes change. */
+typedef enum {
+    FF_UNTRIED = 0,
+    FF_READY,
+    FF_UNAVAILABLE
+} ff_status_t;
+
+typedef struct {
+    ff_status_t status;
+    int fd;
+    struct ff_effect effect;
+    bool playing;
+} ff_pad_t;
+
+static ff_pad_t ff_pads[LINK_MAX_CONTROLLERS];
 
 /* Key code mappings for Linux */
 typedef struct {
@@ -78,27 +162,121 @@ static int open_keyboard_device(void) {
     return -1;
 }
 
-static int open_joystick_device(void) {
-    /* Try to open joystick device */
-    for (int i = 0; i < 8; i++) {
+/* Indices as joydev numbers buttons (BTN_MISC and up, then the codes below
+ * it), so they match what jstest shows */
+static void number_buttons(evdev_pad_t *pad, const unsigned long *key_bits) {
+    memset(pad->button_index, NO_BUTTON, sizeof(pad->button_index));
+    pad->button_count = 0;
+    
+    for (int pass = 0; pass < 2; pass++) {
+        int first = pass == 0 ? BTN_MISC : 0;
+        int last = pass == 0 ? KEY_MAX : BTN_MISC - 1;
+        for (int code = first; code <= last && pad->button_count < MAX_PAD_BUTTONS; code++) {
+            if (TEST_BIT(code, key_bits)) {
+                pad->button_index[code] = (uint8_t)pad->button_count++;
+            }
+        }
+    }
+}
+
+/* Read every key and axis from the kernel, after opening or lost events */
+static void resync_pad(evdev_pad_t *pad) {
+    unsigned long key_state[NBITS(KEY_CNT)] = {0};
+    
+    ioctl(pad->fd, EVIOCGKEY(sizeof(key_state)), key_state);
+    pad->pressed = 0;
+    for (int code = 0; code < KEY_CNT; code++) {
+        if (TEST_BIT(code, key_state) && pad->button_index[code] != NO_BUTTON) {
+            pad->pressed |= 1ULL << pad->button_index[code];
+        }
+    }
+    for (int axis = 0; axis < ABS_CNT; axis++) {
+        if (pad->has_abs[axis]) {
+            ioctl(pad->fd, EVIOCGABS(axis), &pad->abs[axis]);
+        }
+    }
+}
+
+/* Gamepads: devices with gamepad buttons and an X/Y stick */
+static bool open_pad(evdev_pad_t *pad, const char *path) {
+    unsigned long ev_bits[NBITS(EV_CNT)] = {0};
+    unsigned long key_bits[NBITS(KEY_CNT)] = {0};
+    unsigned long abs_bits[NBITS(ABS_CNT)] = {0};
+    
+    int fd = open(path, O_RDONLY | O_NONBLOCK);
+    if (fd < 0) {
+        return false;
+    }
+    if (ioctl(fd, EVIOCGBIT(0, sizeof(ev_bits)), ev_bits) < 0 ||
+        !TEST_BIT(EV_KEY, ev_bits) || !TEST_BIT(EV_ABS, ev_bits) ||
+        ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(key_bits)), key_bits) < 0 ||
+        ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(abs_bits)), abs_bits) < 0 ||
+        !(TEST_BIT(BTN_GAMEPAD, key_bits) || TEST_BIT(BTN_JOYSTICK, key_bits)) ||
+        !TEST_BIT(ABS_X, abs_bits) || !TEST_BIT(ABS_Y, abs_bits)) {
+        close(fd);
+        return false;
+    }
+    
+    memset(pad, 0, sizeof(*pad));
+    pad->fd = fd;
+    snprintf(pad->path, sizeof(pad->path), "%s", path);
+    number_buttons(pad, key_bits);
+    for (int axis = 0; axis < ABS_CNT; axis++) {
+        pad->has_abs[axis] = TEST_BIT(axis, abs_bits);
+    }
+    
+    /* Xbox and PlayStation drivers put the right stick on RX/RY and the
+     * triggers on Z/RZ; simpler HID pads put the right stick on Z/RZ */
+    if (pad->has_abs[ABS_RX] && pad->has_abs[ABS_RY]) {
+        pad->right_x = ABS_RX;
+        pad->right_y = ABS_RY;
+        pad->left_trigger = pad->has_abs[ABS_Z] ? ABS_Z : -1;
+        pad->right_trigger = pad->has_abs[ABS_RZ] ? ABS_RZ : -1;
+    } else {
+        pad->right_x = ABS_Z;
+        pad->right_y = ABS_RZ;
+        pad->left_trigger = pad->has_abs[ABS_BRAKE] ? ABS_BRAKE : -1;
+        pad->right_trigger = pad->has_abs[ABS_GAS] ? ABS_GAS : -1;
+    }
+    
+    /* Event times on the clock timing_now_us() reads */
+    int clock = CLOCK_MONOTONIC;
+    ioctl(fd, EVIOCSCLOCKID, &clock);
+    
+    resync_pad(pad);
+    return true;
+}
+
+static int open_pad_devices(void) {
+    pad_count = 0;
+    
+    for (int i = 0; i < MAX_EVENT_DEVICES && pad_count < LINK_MAX_CONTROLLERS; i++) {
         char path[64];
-        snprintf(path, sizeof(path), "/dev/input/js%d", i);
+        snprintf(path, sizeof(path), "/dev/input/event%d", i);
         
-        int fd = open(path, O_RDONLY | O_NONBLOCK);
-        if (fd >= 0) {
-            printf("Found joystick at %s\n", path);
-            return fd;
+        if (open_pad(&pads[pad_count], path)) {
+            char name[128] = "";
+            ioctl(pads[pad_count].fd, EVIOCGNAME(sizeof(name)), name);
+            printf("Found gamepad at %s: %s (controller %d, %d buttons)\n",
+                   path, name, pad_count + 1, pads[pad_count].button_count);
+            pad_count++;
         }
     }
+    for (int i = pad_count; i < LINK_MAX_CONTROLLERS; i++) {
+        pads[i].fd = -1;
+    }
     
-    return -1;
+    return pad_count;
 }
 
 bool platform_input_init(void) {
     keyboard_fd = open_keyboard_device();
-    joystick_fd = open_joystick_device();
+    int gamepads = open_pad_devices();
+    
+    controller_state_init(&primary_state);
+    bound_config = NULL;
     
-    if (keyboard_fd < 0 && joystick_fd < 0) {
+    if (keyboard_fd < 0 && gamepads == 0) {
         fprintf(stderr, "Warning: No input devices found\n");
         fprintf(stderr, "Note: You may need to run with sudo or add yourself to the 'input' group\n");
     }
@@ -111,13 +289,193 @@ void platform_input_cleanup(void) {
         close(keyboard_fd);
         keyboard_fd = -1;
     }
-    if (joystick_fd >= 0) {
-        close(joystick_fd);
-        joystick_fd = -1;
+    for (int i = 0; i < LINK_MAX_CONTROLLERS; i++) {
+        if (pads[i].fd >= 0) {
+            close(pads[i].fd);
+            pads[i].fd = -1;
+        }
+        if (ff_pads[i].status == FF_READY) {
+            ioctl(ff_pads[i].fd, EVIOCRMFF, ff_pads[i].effect.id);
+            close(ff_pads[i].fd);
+        }
+        ff_pads[i].status = FF_UNTRIED;
+    }
+    pad_count = 0;
+}
+
+void platform_input_close_fd(int fd) {
+    if (fd < 0) {
+        return;
+    }
+    if (fd == keyboard_fd) {
+        fprintf(stderr, "\nWarning: Keyboard device disconnected\n");
+        close(keyboard_fd);
+        keyboard_fd = -1;
+        controller_state_init(&primary_state);
+        return;
+    }
+    for (int i = 0; i < LINK_MAX_CONTROLLERS; i++) {
+        if (pads[i].fd == fd) {
+            /* Its slot reads as neutral from now on */
+            fprintf(stderr, "\nWarning: Gamepad %s disconnected\n", pads[i].path);
+            close(pads[i].fd);
+            pads[i].fd = -1;
+            return;
+        }
     }
 }
 
-void platform_input_poll(controller_state_t *state, config_t *config) {
+static void read_pad(evdev_pad_t *pad) {
+    struct input_event ev;
+    
+    while (read(pad->fd, &ev, sizeof(ev)) == sizeof(ev)) {
+        if (ev.type == EV_SYN) {
+            /* The kernel's buffer overflowed: drop events up to the next
+             * report, then read the whole state back */
+            if (ev.code == SYN_DROPPED) {
+                pad->dropped = true;
+            } else if (ev.code == SYN_REPORT && pad->dropped) {
+                pad->dropped = false;
+                resync_pad(pad);
+            }
+            continue;
+        }
+        if (pad->dropped) {
+            continue;
+        }
+        
+        if (ev.type == EV_KEY && ev.code < KEY_CNT && pad->button_index[ev.code] != NO_BUTTON) {
+            uint8_t index = pad->button_index[ev.code];
+            if (ev.value != 0) {
+                pad->pressed |= 1ULL << index;
+                if (ev.value == 1) {
+                    g_raw_button = index;
+                }
+            } else {
+                pad->pressed &= ~(1ULL << index);
+            }
+        } else if (ev.type == EV_ABS && ev.code < ABS_CNT) {
+            pad->abs[ev.code].value = ev.value;
+        }
+    }
+}
+
+static bool pad_key_down(const evdev_pad_t *pad, int code) {
+    uint8_t index = pad->button_index[code];
+    return index != NO_BUTTON && (pad->pressed & (1ULL << index));
+}
+
+/* Axis position as 0-255 over the range the kernel reports for it */
+static int scale_axis(const struct input_absinfo *abs) {
+    long range = (long)abs->maximum - abs->minimum;
+    if (range <= 0) {
+        return STICK_CENTER;
+    }
+    long value = ((long)abs->value - abs->minimum) * 255 / range;
+    if (value < 0) value = 0;
+    if (value > 255) value = 255;
+    return (int)value;
+}
+
+/* Which side of its range an axis is pushed to: -1, 0 or 1. Hats are
+ * usually -1..1 but some drivers report 0..2 or wider. */
+static int axis_side(const struct input_absinfo *abs) {
+    long center = ((long)abs->minimum + abs->maximum) / 2;
+    long margin = ((long)abs->maximum - abs->minimum) / 4;
+    if (abs->value < center - margin) return -1;
+    if (abs->value > center + margin) return 1;
+    return 0;
+}
+
+static void stick_to_state(const evdev_pad_t *pad, int axis_x, int axis_y,
+                           const stick_calibration_t *cal, const config_t *config,
+                           uint8_t *x, uint8_t *y, int *raw_x, int *raw_y) {
+    if (!pad->has_abs[axis_x] || !pad->has_abs[axis_y]) {
+        return;
+    }
+    int sx = scale_axis(&pad->abs[axis_x]);
+    int sy = scale_axis(&pad->abs[axis_y]);
+    if (raw_x) {
+        *raw_x = sx;
+        *raw_y = sy;
+    }
+    
+    /* Deadzone around the calibrated center if there is one */
+    bool calibrated = cal && cal->is_calibrated;
+    int center_x = calibrated ? cal->center_x : STICK_CENTER;
+    int center_y = calibrated ? cal->center_y : STICK_CENTER;
+    int deadzone = config->controller_deadzone * 128 / 100;
+    if (abs(sx - center_x) <= deadzone && abs(sy - center_y) <= deadzone) {
+        return;
+    }
+    
+    *x = calibrated ? apply_stick_calibration(sx, cal, false) : (uint8_t)sx;
+    *y = calibrated ? apply_stick_calibration(sy, cal, true) : (uint8_t)sy;
+}
+
+static bool trigger_pulled(const evdev_pad_t *pad, int axis) {
+    if (axis < 0) {
+        return false;
+    }
+    const struct input_absinfo *abs = &pad->abs[axis];
+    return abs->value > abs->minimum + (abs->maximum - abs->minimum) / 2;
+}
+
+/* Button index -> Switch buttons from [ControllerBindings] */
+static void bind_buttons(const config_t *config) {
+    memset(binding_masks, 0, sizeof(binding_masks));
+    for (int i = 0; i < config->controller_binding_count; i++) {
+        int index = config->controller_bindings[i].controller_button_index;
+        if (index >= 0 && index < MAX_PAD_BUTTONS) {
+            binding_masks[index] |= config->controller_bindings[i].switch_button_mask;
+        }
+    }
+    bound_config = config;
+}
+
+/* The pad's buttons, D-pad and sticks; cal is applied to the sticks (slot 0) */
+static void pad_to_state(const evdev_pad_t *pad, controller_state_t *state,
+                         const config_t *config, const stick_calibration_t *left_cal,
+                         const stick_calibration_t *right_cal) {
+    if (config->use_custom_controller_bindings && config->controller_bindings) {
+        if (bound_config != config) {
+            bind_buttons(config);
+        }
+        for (int index = 0; index < pad->button_count; index++) {
+            if (pad->pressed & (1ULL << index)) {
+                state->buttons |= binding_masks[index];
+            }
+        }
+    } else {
+        for (size_t i = 0; i < NUM_DEFAULT_PAD_BUTTONS; i++) {
+            if (pad_key_down(pad, default_pad_buttons[i].code)) {
+                state->buttons |= default_pad_buttons[i].mask;
+            }
+        }
+    }
+    
+    /* Analog triggers, for pads that don't also send BTN_TL2/BTN_TR2 */
+    if (trigger_pulled(pad, pad->left_trigger)) state->buttons |= BTN_ZL;
+    if (trigger_pulled(pad, pad->right_trigger)) state->buttons |= BTN_ZR;
+    
+    /* D-pad as a hat, as buttons, or both */
+    int hat_x = pad->has_abs[ABS_HAT0X] ? axis_side(&pad->abs[ABS_HAT0X]) : 0;
+    int hat_y = pad->has_abs[ABS_HAT0Y] ? axis_side(&pad->abs[ABS_HAT0Y]) : 0;
+    state->dpad_up |= hat_y < 0 || pad_key_down(pad, BTN_DPAD_UP);
+    state->dpad_down |= hat_y > 0 || pad_key_down(pad, BTN_DPAD_DOWN);
+    state->dpad_left |= hat_x < 0 || pad_key_down(pad, BTN_DPAD_LEFT);
+    state->dpad_right |= hat_x > 0 || pad_key_down(pad, BTN_DPAD_RIGHT);
+    
+    bool raw = left_cal != NULL;
+    stick_to_state(pad, ABS_X, ABS_Y, left_cal, config, &state->lx, &state->ly,
+                   raw ? &g_raw_lx : NULL, raw ? &g_raw_ly : NULL);
+    stick_to_state(pad, pad->right_x, pad->right_y, right_cal, config, &state->rx, &state->ry,
+                   raw ? &g_raw_rx : NULL, raw ? &g_raw_ry : NULL);
+}
+
+void platform_input_poll(controller_state_t *out, config_t *config) {
+    controller_state_t *state = &primary_state;
+    
     /* Poll keyboard events */
     if (config->enable_keyboard && keyboard_fd >= 0) {
         struct input_event ev;
@@ -172,96 +530,148 @@ void platform_input_poll(controller_state_t *state, config_t *config) {
                             default: break;
                         }
                         break;
+                    
+                    case INPUT_TYPE_MACRO:
+                        state->macro_key = is_pressed ? binding->value.macro_slot + 1 : 0;
+                        break;
                 }
             }
         }
     }
     
-    /* Poll joystick events */
-    if (config->enable_controller && joystick_fd >= 0) {
-        struct js_event js;
+    *out = primary_state;
+    
+    /* The first gamepad adds to the keyboard */
+    if (config->enable_controller && pads[0].fd >= 0) {
+        read_pad(&pads[0]);
+        pad_to_state(&pads[0], out, config, &config->left_stick_cal, &config->right_stick_cal);
+    }
+}
+
+bool platform_input_poll_gamepad(int slot, controller_state_t *state, config_t *config) {
+    if (slot < 1 || slot >= LINK_MAX_CONTROLLERS || pads[slot].fd < 0 ||
+        !config->enable_controller) {
+        return false;
+    }
+    
+    read_pad(&pads[slot]);
+    pad_to_state(&pads[slot], state, config, NULL, NULL);
+    return true;
+}
+
+int platform_input_get_fds(const config_t *config, int *fds, int max) {
+    int count = 0;
+    
+    if (config->enable_keyboard && keyboard_fd >= 0 && count < max) {
+        fds[count++] = keyboard_fd;
+    }
+    if (config->enable_controller) {
+        /* Slot 0 and the slots platform_input_poll_gamepad is called for */
+        for (int slot = 0; slot < config->controllers && slot < LINK_MAX_CONTROLLERS; slot++) {
+            if (pads[slot].fd >= 0 && count < max) {
+                fds[count++] = pads[slot].fd;
+            }
+        }
+    }
+    return count;
+}
+
+static bool open_ff_device(ff_pad_t *pad, const char *path) {
+    unsigned long ff_bits[(FF_MAX + 8 * sizeof(unsigned long)) / (8 * sizeof(unsigned long))] = {0};
+    
+    pad->fd = open(path, O_RDWR | O_NONBLOCK);
+    if (pad->fd < 0) {
+        fprintf(stderr, "Warning: Could not open %s for rumble: %s\n", path, strerror(errno));
+        return false;
+    }
+    
+    if (ioctl(pad->fd, EVIOCGBIT(EV_FF, sizeof(ff_bits)), ff_bits) < 0 ||
+        !(ff_bits[FF_RUMBLE / (8 * sizeof(unsigned long))] &
+          (1UL << (FF_RUMBLE % (8 * sizeof(unsigned long)))))) {
+        fprintf(stderr, "Warning: %s has no rumble support\n", path);
+        close(pad->fd);
+        return false;
+    }
+    
+    /* Plays until stopped; magnitudes are filled in per update */
+    memset(&pad->effect, 0, sizeof(pad->effect));
+    pad->effect.type = FF_RUMBLE;
+    pad->effect.id = -1;
+    pad->effect.replay.length = 0;
+    pad->playing = false;
+    
+    printf("Rumble on %s\n", path);
+    return true;
+}
+
+static bool ff_pad_ready(int slot, const config_t *config) {
+    ff_pad_t *pad = &ff_pads[slot];
+    
+    if (pad->status == FF_UNTRIED) {
+        char path[MAX_PATH_LEN];
+        bool have_path;
         
-        while (read(joystick_fd, &js, sizeof(js)) == sizeof(js)) {
-            if (js.type & JS_EVENT_BUTTON) {
-                bool pressed = (js.value != 0);
-                
-                /* Standard button mapping */
-                switch (js.number) {
-                    case 0: /* A */
-                        if (pressed) state->buttons |= BTN_B;
-                        else state->buttons &= ~BTN_B;
-                        break;
-                    case 1: /* B */
-                        if (pressed) state->buttons |= BTN_A;
-                        else state->buttons &= ~BTN_A;
-                        break;
-                    case 2: /* X */
-                        if (pressed) state->buttons |= BTN_Y;
-                        else state->buttons &= ~BTN_Y;
-                        break;
-                    case 3: /* Y */
-                        if (pressed) state->buttons |= BTN_X;
-                        else state->buttons &= ~BTN_X;
-                        break;
-                    case 4: /* LB */
-                        if (pressed) state->buttons |= BTN_L;
-                        else state->buttons &= ~BTN_L;
-                        break;
-                    case 5: /* RB */
-                        if (pressed) state->buttons |= BTN_R;
-                        else state->buttons &= ~BTN_R;
-                        break;
-                    case 6: /* Back */
-                        if (pressed) state->buttons |= BTN_MINUS;
-                        else state->buttons &= ~BTN_MINUS;
-                        break;
-                    case 7: /* Start */
-                        if (pressed) state->buttons |= BTN_PLUS;
-                        else state->buttons &= ~BTN_PLUS;
-                        break;
-                    case 9: /* Left stick */
-                        if (pressed) state->buttons |= BTN_LSTICK;
-                        else state->buttons &= ~BTN_LSTICK;
-                        break;
-                    case 10: /* Right stick */
-                        if (pressed) state->buttons |= BTN_RSTICK;
-                        else state->buttons &= ~BTN_RSTICK;
-                        break;
-                }
-            } else if (js.type & JS_EVENT_AXIS) {
-                int deadzone = (int)(config->controller_deadzone / 100.0f * 32767.0f);
-                
-                if (abs(js.value) < deadzone) {
-                    js.value = 0;
-                }
-                
-                switch (js.number) {
-                    case 0: /* Left X */
-                        state->lx = (uint8_t)((js.value + 32768) >> 8);
-                        break;
-                    case 1: /* Left Y */
-                        state->ly = (uint8_t)(255 - ((js.value + 32768) >> 8));
-                        break;
-                    case 2: /* Right X */
-                        state->rx = (uint8_t)((js.value + 32768) >> 8);
-                        break;
-                    case 3: /* Right Y */
-                        state->ry = (uint8_t)(255 - ((js.value + 32768) >> 8));
-                        break;
-                    case 6: /* D-pad X */
-                        if (js.value < -16384) state->dpad_left = true;
-                        else if (js.value > 16384) state->dpad_right = true;
-                        else { state->dpad_left = false; state->dpad_right = false; }
-                        break;
-                    case 7: /* D-pad Y */
-                        if (js.value < -16384) state->dpad_up = true;
-                        else if (js.value > 16384) state->dpad_down = true;
-                        else { state->dpad_up = false; state->dpad_down = false; }
-                        break;
-                }
+        if (slot == 0 && config->rumble_device[0] != '\0') {
+            snprintf(path, sizeof(path), "%s", config->rumble_device);
+            have_path = true;
+        } else {
+            have_path = pads[slot].fd >= 0;
+            snprintf(path, sizeof(path), "%s", pads[slot].path);
+        }
+        pad->status = (have_path && open_ff_device(pad, path)) ? FF_READY : FF_UNAVAILABLE;
+    }
+    return pad->status == FF_READY;
+}
+
+static bool ff_write_play(ff_pad_t *pad, int value) {
+    struct input_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = EV_FF;
+    ev.code = (uint16_t)pad->effect.id;
+    ev.value = value;
+    return write(pad->fd, &ev, sizeof(ev)) == sizeof(ev);
+}
+
+bool platform_rumble(int slot, const rumble_t *rumble, const config_t *config) {
+    if (slot < 0 || slot >= LINK_MAX_CONTROLLERS || !config->enable_rumble ||
+        !ff_pad_ready(slot, config)) {
+        return false;
+    }
+    
+    ff_pad_t *pad = &ff_pads[slot];
+    bool on = rumble->strong != 0 || rumble->weak != 0;
+    bool uploaded = pad->effect.id >= 0;
+    
+    if (!on) {
+        if (pad->playing) {
+            ff_write_play(pad, 0);
+            pad->playing = false;
+        }
+        return true;
+    }
+    
+    /* Upload the first time, then update the same effect in place (which
+     * takes effect immediately, even while it plays) when anything changed */
+    if (!uploaded || pad->effect.u.rumble.strong_magnitude != rumble->strong ||
+        pad->effect.u.rumble.weak_magnitude != rumble->weak) {
+        pad->effect.u.rumble.strong_magnitude = rumble->strong;
+        pad->effect.u.rumble.weak_magnitude = rumble->weak;
+        if (ioctl(pad->fd, EVIOCSFF, &pad->effect) < 0) {
+            fprintf(stderr, "Warning: Rumble upload failed: %s\n", strerror(errno));
+            /* Upload again next time, whatever the magnitudes */
+            pad->effect.u.rumble.strong_magnitude = 0;
+            pad->effect.u.rumble.weak_magnitude = 0;
+            if (!uploaded) {
+                pad->effect.id = -1;
             }
+            return false;
         }
     }
+    
+    if (!pad->playing) {
+        pad->playing = ff_write_play(pad, 1);
+    }
+    return pad->playing;
 }
 
 #endif /* __linux__ */
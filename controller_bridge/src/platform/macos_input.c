@@ -103,6 +103,89 @@ void platform_input_cleanup(void) {
     }
 }
 
+static void read_device(IOHIDDeviceRef device, controller_state_t *state) {
+    CFArrayRef elements = IOHIDDeviceCopyMatchingElements(device, NULL, kIOHIDOptionsTypeNone);
+    
+    if (elements) {
+        CFIndex element_count = CFArrayGetCount(elements);
+        
+        for (CFIndex i = 0; i < element_count; i++) {
+            IOHIDElementRef element = (IOHIDElementRef)CFArrayGetValueAtIndex(elements, i);
+            IOHIDElementType type = IOHIDElementGetType(element);
+            
+            if (type == kIOHIDElementTypeInput_Button ||
+                type == kIOHIDElementTypeInput_Axis) {
+                
+                IOHIDValueRef value;
+                if (IOHIDDeviceGetValue(device, element, &value) == kIOReturnSuccess) {
+                    CFIndex int_value = IOHIDValueGetIntegerValue(value);
+                    uint32_t usage = IOHIDElementGetUsage(element);
+                    
+                    /* Button handling */
+                    if (type == kIOHIDElementTypeInput_Button) {
+                        bool pressed = (int_value != 0);
+                        
+                        /* Map common button usages */
+                        switch (usage) {
+                            case 0x01: /* Button 1 (A) */
+                                if (pressed) state->buttons |= BTN_B;
+                                else state->buttons &= ~BTN_B;
+                                break;
+                            case 0x02: /* Button 2 (B) */
+                                if (pressed) state->buttons |= BTN_A;
+                                else state->buttons &= ~BTN_A;
+                                break;
+                        }
+                    }
+                }
+            }
+        }
+        
+        CFRelease(elements);
+    }
+}
+
+static long device_location(IOHIDDeviceRef device) {
+    long location = 0;
+    CFTypeRef ref = IOHIDDeviceGetProperty(device, CFSTR(kIOHIDLocationIDKey));
+    if (ref && CFGetTypeID(ref) == CFNumberGetTypeID()) {
+        CFNumberGetValue((CFNumberRef)ref, kCFNumberLongType, &location);
+    }
+    return location;
+}
+
+static int compare_location(const void *a, const void *b) {
+    long la = device_location(*(IOHIDDeviceRef const *)a);
+    long lb = device_location(*(IOHIDDeviceRef const *)b);
+    return (la > lb) - (la < lb);
+}
+
+/* Gamepads in USB location order, so each keeps its slot from poll to poll */
+static bool poll_gamepad(int slot, controller_state_t *state) {
+    bool found = false;
+    
+    if (!hid_manager) {
+        return false;
+    }
+    
+    CFSetRef device_set = IOHIDManagerCopyDevices(hid_manager);
+    if (device_set) {
+        CFIndex device_count = CFSetGetCount(device_set);
+        if (device_count > slot) {
+            IOHIDDeviceRef *devices = malloc(device_count * sizeof(IOHIDDeviceRef));
+            if (devices) {
+                CFSetGetValues(device_set, (const void **)devices);
+                qsort(devices, (size_t)device_count, sizeof(IOHIDDeviceRef), compare_location);
+                read_device(devices[slot], state);
+                found = true;
+                free(devices);
+            }
+        }
+        CFRelease(device_set);
+    }
+    return found;
+}
+
 void platform_input_poll(controller_state_t *state, config_t *config) {
     /* Poll keyboard using Carbon Event Manager */
     if (config->enable_keyboard) {
@@ -150,69 +233,34 @@ void platform_input_poll(controller_state_t *state, config_t *config) {
                             default: break;
                         }
                         break;
+                    
+                    case INPUT_TYPE_MACRO:
+                        state->macro_key = binding->value.macro_slot + 1;
+                        break;
                 }
             }
         }
     }
     
     /* Poll HID devices (controllers) */
-    if (config->enable_controller && hid_manager) {
-        CFSetRef device_set = IOHIDManagerCopyDevices(hid_manager);
-        if (device_set) {
-            CFIndex device_count = CFSetGetCount(device_set);
-            if (device_count > 0) {
-                IOHIDDeviceRef *devices = malloc(device_count * sizeof(IOHIDDeviceRef));
-                CFSetGetValues(device_set, (const void **)devices);
-                
-                /* Poll first device only */
-                if (device_count > 0) {
-                    IOHIDDeviceRef device = devices[0];
-                    CFArrayRef elements = IOHIDDeviceCopyMatchingElements(device, NULL, kIOHIDOptionsTypeNone);
-                    
-                    if (elements) {
-                        CFIndex element_count = CFArrayGetCount(elements);
-                        
-                        for (CFIndex i = 0; i < element_count; i++) {
-                            IOHIDElementRef element = (IOHIDElementRef)CFArrayGetValueAtIndex(elements, i);
-                            IOHIDElementType type = IOHIDElementGetType(element);
-                            
-                            if (type == kIOHIDElementTypeInput_Button ||
-                                type == kIOHIDElementTypeInput_Axis) {
-                                
-                                IOHIDValueRef value;
-                                if (IOHIDDeviceGetValue(device, element, &value) == kIOReturnSuccess) {
-                                    CFIndex int_value = IOHIDValueGetIntegerValue(value);
-                                    uint32_t usage = IOHIDElementGetUsage(element);
-                                    
-                                    /* Button handling */
-                                    if (type == kIOHIDElementTypeInput_Button) {
-                                        bool pressed = (int_value != 0);
-                                        
-                                        /* Map common button usages */
-                                        switch (usage) {
-                                            case 0x01: /* Button 1 (A) */
-                                                if (pressed) state->buttons |= BTN_B;
-                                                else state->buttons &= ~BTN_B;
-                                                break;
-                                            case 0x02: /* Button 2 (B) */
-                                                if (pressed) state->buttons |= BTN_A;
-                                                else state->buttons &= ~BTN_A;
-                                                break;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                        
-                        CFRelease(elements);
-                    }
-                }
-                
-                free(devices);
-            }
-            CFRelease(device_set);
-        }
+    if (config->enable_controller) {
+        poll_gamepad(0, state);
     }
 }
 
+bool platform_input_poll_gamepad(int slot, controller_state_t *state, config_t *config) {
+    if (slot < 1 || slot >= LINK_MAX_CONTROLLERS || !config->enable_controller) {
+        return false;
+    }
+    return poll_gamepad(slot, state);
+}
+
+bool platform_rumble(int slot, const rumble_t *rumble, const config_t *config) {
+    /* Not supported on this platform yet */
+    (void)slot;
+    (void)rumble;
+    (void)config;
+    return false;
+}
+
 #endif /* __APPLE__ */
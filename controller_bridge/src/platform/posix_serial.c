@@ -1,18 +1,82 @@
 #if defined(__unix__) || defined(__APPLE__)
 
 #include "controller_bridge.h"
+#include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <termios.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
+
+#ifdef __linux__
+#include <linux/serial.h>
+#endif
+#ifdef __APPLE__
+#include <IOKit/serial/ioss.h>
+#endif
 
 typedef struct {
     int fd;
     bool is_open;
+    char name[PATH_MAX];
 } posix_serial_t;
 
+/* termios constant for a rate, 0 if there is none */
+static speed_t speed_constant(int baud_rate) {
+    switch (baud_rate) {
+        case 9600:    return B9600;
+        case 19200:   return B19200;
+        case 38400:   return B38400;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+#ifdef B460800
+        case 460800:  return B460800;
+#endif
+#ifdef B921600
+        case 921600:  return B921600;
+#endif
+#ifdef B1000000
+        case 1000000: return B1000000;
+#endif
+#ifdef B1500000
+        case 1500000: return B1500000;
+#endif
+#ifdef B2000000
+        case 2000000: return B2000000;
+#endif
+#ifdef B3000000
+        case 3000000: return B3000000;
+#endif
+        default:      return 0;
+    }
+}
+
+/* Set the rate in options and apply them */
+static bool apply_baud(int fd, struct termios *options, int baud_rate) {
+    speed_t speed = speed_constant(baud_rate);
+    
+#ifdef __APPLE__
+    if (speed == 0) {
+        /* Rates above 230400 go through IOSSIOSPEED, after tcsetattr (which
+         * would reset it) */
+        cfsetispeed(options, B115200);
+        cfsetospeed(options, B115200);
+        speed_t custom = (speed_t)baud_rate;
+        return tcsetattr(fd, TCSANOW, options) == 0 && ioctl(fd, IOSSIOSPEED, &custom) == 0;
+    }
+#endif
+    if (speed == 0) {
+        return false;
+    }
+    cfsetispeed(options, speed);
+    cfsetospeed(options, speed);
+    return tcsetattr(fd, TCSANOW, options) == 0;
+}
+
 serial_port_t serial_open(const char *port_name, int baud_rate) {
     posix_serial_t *port = malloc(sizeof(posix_serial_t));
     if (!port) {
@@ -20,6 +84,7 @@ serial_port_t serial_open(const char *port_name, int baud_rate) {
     }
     
     port->is_open = false;
+    port->name[0] = '\0';
     
     /* Open serial port */
     port->fd = open(port_name, O_RDWR | O_NOCTTY | O_NDELAY);
@@ -39,21 +104,6 @@ serial_port_t serial_open(const char *port_name, int baud_rate) {
         return NULL;
     }
     
-    /* Set baud rate */
-    speed_t speed;
-    switch (baud_rate) {
-        case 9600:   speed = B9600;   break;
-        case 19200:  speed = B19200;  break;
-        case 38400:  speed = B38400;  break;
-        case 57600:  speed = B57600;  break;
-        case 115200: speed = B115200; break;
-        case 230400: speed = B230400; break;
-        default:     speed = B115200; break;
-    }
-    
-    cfsetispeed(&options, speed);
-    cfsetospeed(&options, speed);
-    
     /* 8N1 mode */
     options.c_cflag &= ~PARENB;  /* No parity */
     options.c_cflag &= ~CSTOPB;  /* 1 stop bit */
@@ -80,8 +130,9 @@ serial_port_t serial_open(const char *port_name, int baud_rate) {
     options.c_cc[VMIN] = 0;
     options.c_cc[VTIME] = 1;  /* 0.1 seconds */
     
-    /* Apply settings */
-    if (tcsetattr(port->fd, TCSANOW, &options) != 0) {
+    /* Apply settings; rates the port doesn't know fall back to 115200 */
+    if (!apply_baud(port->fd, &options, baud_rate) &&
+        !apply_baud(port->fd, &options, 115200)) {
         fprintf(stderr, "Error: Could not set terminal attributes\n");
         close(port->fd);
         free(port);
@@ -94,6 +145,8 @@ serial_port_t serial_open(const char *port_name, int baud_rate) {
     /* Allow Pico to reset and stabilize */
     sleep(2);  /* 2 seconds, matching Python's time.sleep(2) */
     
+    strncpy(port->name, port_name, sizeof(port->name) - 1);
+    port->name[sizeof(port->name) - 1] = '\0';
     port->is_open = true;
     return (serial_port_t)port;
 }
@@ -129,10 +182,95 @@ bool serial_write(serial_port_t port, const uint8_t *data, size_t len) {
     return (size_t)bytes_written == len;
 }
 
+int serial_read(serial_port_t port, uint8_t *data, size_t len) {
+    if (!port) return -1;
+    
+    posix_serial_t *posix_port = (posix_serial_t *)port;
+    
+    if (!posix_port->is_open || posix_port->fd < 0) return -1;
+    
+    /* Port is opened with O_NDELAY, so this never blocks */
+    ssize_t bytes_read = read(posix_port->fd, data, len);
+    
+    if (bytes_read < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+    
+    return (int)bytes_read;
+}
+
+int serial_get_fd(serial_port_t port) {
+    posix_serial_t *posix_port = (posix_serial_t *)port;
+    return (posix_port && posix_port->is_open) ? posix_port->fd : -1;
+}
+
 bool serial_is_open(serial_port_t port) {
     if (!port) return false;
     posix_serial_t *posix_port = (posix_serial_t *)port;
     return posix_port->is_open;
 }
 
+bool serial_set_baud(serial_port_t port, int baud_rate) {
+    if (!port) return false;
+    
+    posix_serial_t *posix_port = (posix_serial_t *)port;
+    struct termios options;
+    
+    if (!posix_port->is_open || tcgetattr(posix_port->fd, &options) != 0) {
+        return false;
+    }
+    tcdrain(posix_port->fd);
+    return apply_baud(posix_port->fd, &options, baud_rate);
+}
+
+bool serial_set_low_latency(serial_port_t port) {
+    if (!port) return false;
+    
+    posix_serial_t *posix_port = (posix_serial_t *)port;
+    bool applied = false;
+    
+    if (!posix_port->is_open) return false;
+    
+#ifdef __linux__
+    /* Generic hint to the tty layer and older usb-serial drivers */
+    struct serial_struct serial;
+    if (ioctl(posix_port->fd, TIOCGSERIAL, &serial) == 0) {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        applied = ioctl(posix_port->fd, TIOCSSERIAL, &serial) == 0;
+    }
+    
+    /* FTDI chips hold received bytes for up to latency_timer ms (16 by
+     * default) before sending them to the PC */
+    char real_path[PATH_MAX];
+    if (realpath(posix_port->name, real_path)) {
+        const char *tty = strrchr(real_path, '/');
+        char timer_path[PATH_MAX];
+        int len = snprintf(timer_path, sizeof(timer_path), "/sys/class/tty/%s/device/latency_timer",
+                           tty ? tty + 1 : real_path);
+        
+        /* A name too long for the path can't be a tty with a latency timer */
+        if (len > 0 && (size_t)len < sizeof(timer_path) && access(timer_path, F_OK) == 0) {
+            FILE *timer = fopen(timer_path, "w");
+            bool written = timer && fputs("1", timer) >= 0;
+            if (timer && fclose(timer) != 0) {
+                written = false;
+            }
+            if (written) {
+                printf("FTDI latency timer set to 1 ms\n");
+                applied = true;
+            } else {
+                fprintf(stderr, "Warning: Could not write %s (needs root or a udev rule)\n",
+                        timer_path);
+            }
+        }
+    }
+#elif defined(__APPLE__)
+    /* Receive latency in microseconds */
+    unsigned long latency_us = 1;
+    applied = ioctl(posix_port->fd, IOSSDATALAT, &latency_us) == 0;
+#endif
+    
+    return applied;
+}
+
 #endif /* __unix__ || __APPLE__ */
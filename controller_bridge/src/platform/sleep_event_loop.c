@@ -0,0 +1,47 @@
+#include "controller_bridge.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#else
+#include <unistd.h>
+#endif
+
+/* Windows and macOS: input is polled as key/pad state rather than read from
+ * fds, so just sleep until the deadline and have the main loop poll all */
+struct event_loop {
+    int unused;
+};
+
+event_loop_t *event_loop_create(serial_port_t serial, const config_t *config) {
+    (void)serial;
+    (void)config;
+    event_loop_t *loop = calloc(1, sizeof(event_loop_t));
+#ifdef _WIN32
+    /* Sleep() otherwise rounds up to the 15.6 ms system tick */
+    if (loop) timeBeginPeriod(1);
+#endif
+    return loop;
+}
+
+void event_loop_destroy(event_loop_t *loop) {
+#ifdef _WIN32
+    if (loop) timeEndPeriod(1);
+#endif
+    free(loop);
+}
+
+int event_loop_wait(event_loop_t *loop, uint64_t deadline_us) {
+    (void)loop;
+    uint64_t now_us = timing_now_us();
+
+    if (deadline_us > now_us) {
+#ifdef _WIN32
+        Sleep((DWORD)((deadline_us - now_us + 999) / 1000));
+#else
+        usleep((useconds_t)(deadline_us - now_us));
+#endif
+    }
+    return EVENT_INPUT | EVENT_SERIAL | EVENT_TIMER;
+}
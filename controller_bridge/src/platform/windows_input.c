@@ -129,6 +129,50 @@ void platform_input_cleanup(void) {
     g_dinput_initialized = false;
 }
 
+/* Xbox controller layout to Switch layout */
+static void map_xinput(const XINPUT_GAMEPAD *pad, controller_state_t *state, config_t *config) {
+    /* Map Xbox buttons to Switch layout */
+    if (pad->wButtons & XINPUT_GAMEPAD_A) state->buttons |= BTN_B;      /* Xbox A -> Switch B */
+    if (pad->wButtons & XINPUT_GAMEPAD_B) state->buttons |= BTN_A;      /* Xbox B -> Switch A */
+    if (pad->wButtons & XINPUT_GAMEPAD_X) state->buttons |= BTN_Y;      /* Xbox X -> Switch Y */
+    if (pad->wButtons & XINPUT_GAMEPAD_Y) state->buttons |= BTN_X;      /* Xbox Y -> Switch X */
+    if (pad->wButtons & XINPUT_GAMEPAD_LEFT_SHOULDER) state->buttons |= BTN_L;
+    if (pad->wButtons & XINPUT_GAMEPAD_RIGHT_SHOULDER) state->buttons |= BTN_R;
+    if (pad->bLeftTrigger > 128) state->buttons |= BTN_ZL;
+    if (pad->bRightTrigger > 128) state->buttons |= BTN_ZR;
+    if (pad->wButtons & XINPUT_GAMEPAD_BACK) state->buttons |= BTN_MINUS;
+    if (pad->wButtons & XINPUT_GAMEPAD_START) state->buttons |= BTN_PLUS;
+    if (pad->wButtons & XINPUT_GAMEPAD_LEFT_THUMB) state->buttons |= BTN_LSTICK;
+    if (pad->wButtons & XINPUT_GAMEPAD_RIGHT_THUMB) state->buttons |= BTN_RSTICK;
+    
+    /* D-Pad */
+    if (pad->wButtons & XINPUT_GAMEPAD_DPAD_UP) state->dpad_up = true;
+    if (pad->wButtons & XINPUT_GAMEPAD_DPAD_DOWN) state->dpad_down = true;
+    if (pad->wButtons & XINPUT_GAMEPAD_DPAD_LEFT) state->dpad_left = true;
+    if (pad->wButtons & XINPUT_GAMEPAD_DPAD_RIGHT) state->dpad_right = true;
+    
+    /* Analog sticks with deadzone */
+    int deadzone = (int)(config->controller_deadzone / 100.0f * 32767.0f);
+    
+    if (abs(pad->sThumbLX) > deadzone || abs(pad->sThumbLY) > deadzone) {
+        state->lx = (uint8_t)((pad->sThumbLX + 32768) >> 8);
+        state->ly = (uint8_t)(255 - ((pad->sThumbLY + 32768) >> 8));
+    } else {
+        /* Stick within deadzone - return to center */
+        state->lx = 128;
+        state->ly = 128;
+    }
+    
+    if (abs(pad->sThumbRX) > deadzone || abs(pad->sThumbRY) > deadzone) {
+        state->rx = (uint8_t)((pad->sThumbRX + 32768) >> 8);
+        state->ry = (uint8_t)(255 - ((pad->sThumbRY + 32768) >> 8));
+    } else {
+        /* Stick within deadzone - return to center */
+        state->rx = 128;
+        state->ry = 128;
+    }
+}
+
 void platform_input_poll(controller_state_t *state, config_t *config) {
     /* Poll keyboard */
     if (config->enable_keyboard) {
@@ -175,6 +219,10 @@ void platform_input_poll(controller_state_t *state, config_t *config) {
                             default: break;
                         }
                         break;
+                    
+                    case INPUT_TYPE_MACRO:
+                        state->macro_key = binding->value.macro_slot + 1;
+                        break;
                 }
             }
         }
@@ -190,48 +238,7 @@ void platform_input_poll(controller_state_t *state, config_t *config) {
         
         if (result == ERROR_SUCCESS) {
             controller_found = true;
-            XINPUT_GAMEPAD *pad = &xinput_state.Gamepad;
-            
-            /* Map Xbox buttons to Switch layout */
-            if (pad->wButtons & XINPUT_GAMEPAD_A) state->buttons |= BTN_B;      /* Xbox A -> Switch B */
-            if (pad->wButtons & XINPUT_GAMEPAD_B) state->buttons |= BTN_A;      /* Xbox B -> Switch A */
-            if (pad->wButtons & XINPUT_GAMEPAD_X) state->buttons |= BTN_Y;      /* Xbox X -> Switch Y */
-            if (pad->wButtons & XINPUT_GAMEPAD_Y) state->buttons |= BTN_X;      /* Xbox Y -> Switch X */
-            if (pad->wButtons & XINPUT_GAMEPAD_LEFT_SHOULDER) state->buttons |= BTN_L;
-            if (pad->wButtons & XINPUT_GAMEPAD_RIGHT_SHOULDER) state->buttons |= BTN_R;
-            if (pad->bLeftTrigger > 128) state->buttons |= BTN_ZL;
-            if (pad->bRightTrigger > 128) state->buttons |= BTN_ZR;
-            if (pad->wButtons & XINPUT_GAMEPAD_BACK) state->buttons |= BTN_MINUS;
-            if (pad->wButtons & XINPUT_GAMEPAD_START) state->buttons |= BTN_PLUS;
-            if (pad->wButtons & XINPUT_GAMEPAD_LEFT_THUMB) state->buttons |= BTN_LSTICK;
-            if (pad->wButtons & XINPUT_GAMEPAD_RIGHT_THUMB) state->buttons |= BTN_RSTICK;
-            
-            /* D-Pad */
-            if (pad->wButtons & XINPUT_GAMEPAD_DPAD_UP) state->dpad_up = true;
-            if (pad->wButtons & XINPUT_GAMEPAD_DPAD_DOWN) state->dpad_down = true;
-            if (pad->wButtons & XINPUT_GAMEPAD_DPAD_LEFT) state->dpad_left = true;
-            if (pad->wButtons & XINPUT_GAMEPAD_DPAD_RIGHT) state->dpad_right = true;
-            
-            /* Analog sticks with deadzone */
-            int deadzone = (int)(config->controller_deadzone / 100.0f * 32767.0f);
-            
-            if (abs(pad->sThumbLX) > deadzone || abs(pad->sThumbLY) > deadzone) {
-                state->lx = (uint8_t)((pad->sThumbLX + 32768) >> 8);
-                state->ly = (uint8_t)(255 - ((pad->sThumbLY + 32768) >> 8));
-            } else {
-                /* Stick within deadzone - return to center */
-                state->lx = 128;
-                state->ly = 128;
-            }
-            
-            if (abs(pad->sThumbRX) > deadzone || abs(pad->sThumbRY) > deadzone) {
-                state->rx = (uint8_t)((pad->sThumbRX + 32768) >> 8);
-                state->ry = (uint8_t)(255 - ((pad->sThumbRY + 32768) >> 8));
-            } else {
-                /* Stick within deadzone - return to center */
-                state->rx = 128;
-                state->ry = 128;
-            }
+            map_xinput(&xinput_state.Gamepad, state, config);
         }
         
         /* If no XInput controller, try DirectInput (PS4/PS5/other controllers) */
@@ -376,4 +383,24 @@ void platform_input_poll(controller_state_t *state, config_t *config) {
     }
 }
 
+bool platform_input_poll_gamepad(int slot, controller_state_t *state, config_t *config) {
+    /* XInput user index n drives slot n */
+    XINPUT_STATE xinput_state;
+    if (slot < 1 || slot >= LINK_MAX_CONTROLLERS || !config->enable_controller ||
+        XInputGetState((DWORD)slot, &xinput_state) != ERROR_SUCCESS) {
+        return false;
+    }
+    
+    map_xinput(&xinput_state.Gamepad, state, config);
+    return true;
+}
+
+bool platform_rumble(int slot, const rumble_t *rumble, const config_t *config) {
+    /* Not supported on this platform yet */
+    (void)slot;
+    (void)rumble;
+    (void)config;
+    return false;
+}
+
 #endif /* _WIN32 */
@@ -81,11 +81,12 @@ serial_port_t serial_open(const char *port_name, int baud_rate) {
         return NULL;
     }
     
-    /* Set timeouts - make writes non-blocking for better performance */
+    /* Set timeouts - make writes non-blocking for better performance, and
+     * reads return immediately with whatever has arrived */
     COMMTIMEOUTS timeouts = { 0 };
-    timeouts.ReadIntervalTimeout = 50;
-    timeouts.ReadTotalTimeoutConstant = 50;
-    timeouts.ReadTotalTimeoutMultiplier = 10;
+    timeouts.ReadIntervalTimeout = MAXDWORD;
+    timeouts.ReadTotalTimeoutConstant = 0;
+    timeouts.ReadTotalTimeoutMultiplier = 0;
     timeouts.WriteTotalTimeoutConstant = 0;  /* Non-blocking writes */
     timeouts.WriteTotalTimeoutMultiplier = 0;
     
@@ -138,10 +139,49 @@ bool serial_write(serial_port_t port, const uint8_t *data, size_t len) {
     return true;
 }
 
+int serial_read(serial_port_t port, uint8_t *data, size_t len) {
+    if (!port) return -1;
+    
+    windows_serial_t *win_port = (windows_serial_t *)port;
+    
+    if (!win_port->is_open) return -1;
+    
+    DWORD bytes_read;
+    if (!ReadFile(win_port->handle, data, (DWORD)len, &bytes_read, NULL)) {
+        return -1;
+    }
+    
+    return (int)bytes_read;
+}
+
 bool serial_is_open(serial_port_t port) {
     if (!port) return false;
     windows_serial_t *win_port = (windows_serial_t *)port;
     return win_port->is_open;
 }
 
+bool serial_set_baud(serial_port_t port, int baud_rate) {
+    if (!port) return false;
+    
+    windows_serial_t *win_port = (windows_serial_t *)port;
+    DCB dcb = { 0 };
+    dcb.DCBlength = sizeof(DCB);
+    
+    if (!win_port->is_open) return false;
+    
+    FlushFileBuffers(win_port->handle);
+    if (!GetCommState(win_port->handle, &dcb)) {
+        return false;
+    }
+    dcb.BaudRate = (DWORD)baud_rate;
+    return SetCommState(win_port->handle, &dcb) != 0;
+}
+
+bool serial_set_low_latency(serial_port_t port) {
+    (void)port;
+    /* The FTDI latency timer is a driver setting on Windows (Device Manager,
+     * port properties, Advanced); there is no API for it here */
+    return false;
+}
+
 #endif /* _WIN32 */
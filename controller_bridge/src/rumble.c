@@ -0,0 +1,50 @@
+#include "controller_bridge.h"
+
+/* The console encodes rumble the way it does for its own controllers: 4
+ * bytes per side, a high band and a low band, each with a frequency and an
+ * amplitude. "No rumble" is 00 01 40 40. Only the amplitudes matter for a
+ * two-motor pad:
+ *
+ *   high band amplitude  byte 1 bits 1-7, 0x00 (off) .. 0xC8 (full)
+ *   low band amplitude   byte 3,          0x40 (off) .. 0x72 (full)
+ *
+ * The amplitude codes are roughly logarithmic; a linear scale is close
+ * enough to feel right on a pad with plain on/off-ish motors. */
+#define HIGH_AMP_MAX 0xC8
+#define LOW_AMP_MIN  0x40
+#define LOW_AMP_MAX  0x72
+
+/* The Switch Pico's report descriptor has no report IDs and one output
+ * report: 8 bytes (vendor usage 0x2621), left side then right side */
+#define RUMBLE_REPORT_ID  0
+#define RUMBLE_REPORT_LEN 8
+
+static uint16_t scale(int value, int max) {
+    if (value <= 0) return 0;
+    if (value >= max) return 0xFFFF;
+    return (uint16_t)(value * 0xFFFF / max);
+}
+
+/* Low band amplitude codes all sit in 0x40..0x7F; anything else is not a
+ * rumble side */
+static bool side_valid(const uint8_t *side) {
+    return (side[3] & 0xC0) == LOW_AMP_MIN;
+}
+
+/* Strength of one side, the stronger of its two bands */
+static uint16_t side_magnitude(const uint8_t *side) {
+    uint16_t high = scale(side[1] & 0xFE, HIGH_AMP_MAX);
+    uint16_t low = scale(side[3] - LOW_AMP_MIN, LOW_AMP_MAX - LOW_AMP_MIN);
+    return high > low ? high : low;
+}
+
+bool rumble_from_output(const link_output_t *report, rumble_t *rumble) {
+    /* Left side drives the strong (low-frequency) motor, right the weak one */
+    if (report->report_id != RUMBLE_REPORT_ID || report->len != RUMBLE_REPORT_LEN ||
+        !side_valid(&report->data[0]) || !side_valid(&report->data[4])) {
+        return false;
+    }
+    rumble->strong = side_magnitude(&report->data[0]);
+    rumble->weak = side_magnitude(&report->data[4]);
+    return true;
+}
@@ -0,0 +1,55 @@
+#include "controller_bridge.h"
+#include <string.h>
+
+void send_policy_init(send_policy_t *policy, int min_gap_us, int keepalive_ms) {
+    memset(policy, 0, sizeof(*policy));
+    policy->min_gap_us = min_gap_us > 0 ? (uint32_t)min_gap_us : 0;
+    policy->keepalive_us = keepalive_ms > 0 ? (uint32_t)keepalive_ms * 1000u : 0;
+}
+
+void send_policy_reset(send_policy_t *policy) {
+    policy->have_last = false;
+    policy->pending = false;
+}
+
+send_reason_t send_policy_check(send_policy_t *policy, const uint8_t *state, uint64_t now_us) {
+    if (!policy->have_last) {
+        return SEND_CHANGE;
+    }
+    
+    uint64_t since_us = now_us - policy->last_send_us;
+    if (memcmp(state, policy->last, LINK_STATE_SIZE) != 0) {
+        if (since_us >= policy->min_gap_us) {
+            return SEND_CHANGE;
+        }
+        policy->pending = true;
+        return SEND_NONE;
+    }
+    
+    /* Back to what was last sent before the gap ran out: nothing to send */
+    policy->pending = false;
+    if (policy->keepalive_us != 0 && since_us >= policy->keepalive_us) {
+        return SEND_KEEPALIVE;
+    }
+    return SEND_NONE;
+}
+
+void send_policy_on_sent(send_policy_t *policy, const uint8_t *state, uint64_t now_us) {
+    memcpy(policy->last, state, LINK_STATE_SIZE);
+    policy->have_last = true;
+    policy->pending = false;
+    policy->last_send_us = now_us;
+}
+
+uint64_t send_policy_due_us(const send_policy_t *policy) {
+    if (!policy->have_last) {
+        return 0;
+    }
+    if (policy->pending) {
+        return policy->last_send_us + policy->min_gap_us;
+    }
+    if (policy->keepalive_us != 0) {
+        return policy->last_send_us + policy->keepalive_us;
+    }
+    return UINT64_MAX;
+}
@@ -0,0 +1,275 @@
+#include "controller_bridge.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef SRWLOCK writer_mutex_t;
+typedef CONDITION_VARIABLE writer_cond_t;
+#define mutex_init(m)      InitializeSRWLock(m)
+#define mutex_lock(m)      AcquireSRWLockExclusive(m)
+#define mutex_unlock(m)    ReleaseSRWLockExclusive(m)
+#define cond_init(c)       InitializeConditionVariable(c)
+#define cond_wait(c, m)    SleepConditionVariableSRW(c, m, INFINITE, 0)
+#define cond_broadcast(c)  WakeAllConditionVariable(c)
+#else
+#include <pthread.h>
+typedef pthread_mutex_t writer_mutex_t;
+typedef pthread_cond_t writer_cond_t;
+#define mutex_init(m)      pthread_mutex_init(m, NULL)
+#define mutex_lock(m)      pthread_mutex_lock(m)
+#define mutex_unlock(m)    pthread_mutex_unlock(m)
+#define cond_init(c)       pthread_cond_init(c, NULL)
+#define cond_wait(c, m)    pthread_cond_wait(c, m)
+#define cond_broadcast(c)  pthread_cond_broadcast(c)
+#endif
+
+/* Commands waiting; posting more waits for room */
+#define WRITER_QUEUE_SIZE 16
+
+/* Frames wait unencoded: the sequence number is given when one goes out, so
+ * the wire carries consecutive numbers whatever was reordered or replaced */
+typedef struct {
+    uint8_t type;
+    uint8_t payload[LINK_MAX_PAYLOAD];
+    size_t len;
+    uint64_t posted_us;
+    bool is_state;
+} writer_frame_t;
+
+struct serial_writer {
+    serial_port_t serial;
+    link_encoder_t *link;       /* Only the thread touches it while running */
+    writer_mutex_t mutex;
+    writer_cond_t changed;      /* Something posted, written, or stopping */
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+    bool stopping;
+    bool busy;                  /* The thread is writing a frame it took */
+    bool failed;                /* The last write failed */
+    
+    writer_frame_t queue[WRITER_QUEUE_SIZE];
+    size_t head;
+    size_t count;
+    
+    writer_frame_t state[LINK_MAX_CONTROLLERS];
+    bool state_full[LINK_MAX_CONTROLLERS];
+    int next_state;             /* Slot to look at first, after the last served */
+    
+    uint64_t sent_us[256];      /* When each seq's state frame started out */
+    
+    serial_writer_stats_t stats;
+};
+
+/* Next frame to write, commands first; false if there is none */
+static bool take_frame(serial_writer_t *writer, writer_frame_t *frame) {
+    if (writer->count > 0) {
+        *frame = writer->queue[writer->head];
+        writer->head = (writer->head + 1) % WRITER_QUEUE_SIZE;
+        writer->count--;
+        return true;
+    }
+    /* Round robin, or a busy controller 1 would starve the others */
+    for (int n = 0; n < LINK_MAX_CONTROLLERS; n++) {
+        int i = (writer->next_state + n) % LINK_MAX_CONTROLLERS;
+        if (writer->state_full[i]) {
+            *frame = writer->state[i];
+            writer->state_full[i] = false;
+            writer->next_state = (i + 1) % LINK_MAX_CONTROLLERS;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void writer_loop(serial_writer_t *writer) {
+    writer_frame_t frame;
+    uint8_t packet[LINK_MAX_ENCODED];
+    
+    mutex_lock(&writer->mutex);
+    for (;;) {
+        if (!take_frame(writer, &frame)) {
+            if (writer->stopping) {
+                break;
+            }
+            cond_wait(&writer->changed, &writer->mutex);
+            continue;
+        }
+        writer->busy = true;
+        uint8_t seq = writer->link->seq;
+        size_t packet_len = link_encode(writer->link, frame.type, frame.payload, frame.len, packet);
+        
+        /* Stamped before the write, for the round trip to the ack */
+        uint64_t start_us = timing_now_us();
+        writer->sent_us[seq] = frame.is_state ? start_us : 0;
+        cond_broadcast(&writer->changed);  /* Room in the queue */
+        mutex_unlock(&writer->mutex);
+        
+        /* Returns once the bytes are on the wire (tcdrain on POSIX) */
+        bool written = serial_write(writer->serial, packet, packet_len);
+        uint64_t done_us = timing_now_us();
+        
+        mutex_lock(&writer->mutex);
+        writer->busy = false;
+        writer->failed = !written;
+        
+        serial_writer_stats_t *stats = &writer->stats;
+        uint32_t write_us = (uint32_t)(done_us - start_us);
+        uint32_t queued_us = (uint32_t)(done_us - frame.posted_us);
+        if (written) {
+            stats->frames++;
+            stats->last_done_us = done_us;
+        } else {
+            stats->failures++;
+        }
+        if (write_us >= SERIAL_WRITER_STALL_US) stats->stalls++;
+        if (write_us > stats->max_write_us) stats->max_write_us = write_us;
+        if (queued_us > stats->max_queued_us) stats->max_queued_us = queued_us;
+        cond_broadcast(&writer->changed);  /* For serial_writer_flush */
+    }
+    mutex_unlock(&writer->mutex);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI writer_thread(LPVOID arg) {
+    writer_loop((serial_writer_t *)arg);
+    return 0;
+}
+#else
+static void *writer_thread(void *arg) {
+    writer_loop((serial_writer_t *)arg);
+    return NULL;
+}
+#endif
+
+serial_writer_t *serial_writer_create(serial_port_t serial, link_encoder_t *link) {
+    serial_writer_t *writer = calloc(1, sizeof(serial_writer_t));
+    if (!writer) {
+        return NULL;
+    }
+    writer->serial = serial;
+    writer->link = link;
+    mutex_init(&writer->mutex);
+    cond_init(&writer->changed);
+    
+#ifdef _WIN32
+    writer->thread = CreateThread(NULL, 0, writer_thread, writer, 0, NULL);
+    if (!writer->thread) {
+        free(writer);
+        return NULL;
+    }
+    /* Keep up with the input loop when the machine is busy */
+    SetThreadPriority(writer->thread, THREAD_PRIORITY_ABOVE_NORMAL);
+#else
+    if (pthread_create(&writer->thread, NULL, writer_thread, writer) != 0) {
+        pthread_cond_destroy(&writer->changed);
+        pthread_mutex_destroy(&writer->mutex);
+        free(writer);
+        return NULL;
+    }
+#endif
+    return writer;
+}
+
+void serial_writer_destroy(serial_writer_t *writer) {
+    if (!writer) {
+        return;
+    }
+    mutex_lock(&writer->mutex);
+    writer->stopping = true;
+    cond_broadcast(&writer->changed);
+    mutex_unlock(&writer->mutex);
+    
+#ifdef _WIN32
+    WaitForSingleObject(writer->thread, INFINITE);
+    CloseHandle(writer->thread);
+#else
+    pthread_join(writer->thread, NULL);
+    pthread_cond_destroy(&writer->changed);
+    pthread_mutex_destroy(&writer->mutex);
+#endif
+    free(writer);
+}
+
+static void fill_frame(writer_frame_t *frame, uint8_t type, const uint8_t *payload, size_t len,
+                       bool is_state) {
+    frame->type = type;
+    memcpy(frame->payload, payload, len);
+    frame->len = len;
+    frame->posted_us = timing_now_us();
+    frame->is_state = is_state;
+}
+
+bool serial_writer_post(serial_writer_t *writer, uint8_t type, const uint8_t *payload,
+                        size_t len) {
+    if (len > LINK_MAX_PAYLOAD) {
+        return false;
+    }
+    mutex_lock(&writer->mutex);
+    while (writer->count == WRITER_QUEUE_SIZE) {
+        cond_wait(&writer->changed, &writer->mutex);
+    }
+    writer_frame_t *frame = &writer->queue[(writer->head + writer->count) % WRITER_QUEUE_SIZE];
+    fill_frame(frame, type, payload, len, false);
+    writer->count++;
+    bool ok = !writer->failed;
+    cond_broadcast(&writer->changed);
+    mutex_unlock(&writer->mutex);
+    return ok;
+}
+
+bool serial_writer_post_state(serial_writer_t *writer, int controller, uint8_t type,
+                              const uint8_t *payload, size_t len) {
+    if (controller < 0 || controller >= LINK_MAX_CONTROLLERS || len > LINK_MAX_PAYLOAD) {
+        return false;
+    }
+    mutex_lock(&writer->mutex);
+    if (writer->state_full[controller]) {
+        writer->stats.superseded++;
+    }
+    fill_frame(&writer->state[controller], type, payload, len, true);
+    writer->state_full[controller] = true;
+    bool ok = !writer->failed;
+    cond_broadcast(&writer->changed);
+    mutex_unlock(&writer->mutex);
+    return ok;
+}
+
+bool serial_writer_state_pending(serial_writer_t *writer, int controller) {
+    mutex_lock(&writer->mutex);
+    bool pending = writer->state_full[controller];
+    mutex_unlock(&writer->mutex);
+    return pending;
+}
+
+void serial_writer_flush(serial_writer_t *writer) {
+    mutex_lock(&writer->mutex);
+    for (;;) {
+        bool idle = !writer->busy && writer->count == 0;
+        for (int i = 0; i < LINK_MAX_CONTROLLERS && idle; i++) {
+            idle = !writer->state_full[i];
+        }
+        if (idle) {
+            break;
+        }
+        cond_wait(&writer->changed, &writer->mutex);
+    }
+    mutex_unlock(&writer->mutex);
+}
+
+uint64_t serial_writer_take_sent_us(serial_writer_t *writer, uint8_t seq) {
+    mutex_lock(&writer->mutex);
+    uint64_t sent_us = writer->sent_us[seq];
+    writer->sent_us[seq] = 0;
+    mutex_unlock(&writer->mutex);
+    return sent_us;
+}
+
+void serial_writer_get_stats(serial_writer_t *writer, serial_writer_stats_t *stats) {
+    mutex_lock(&writer->mutex);
+    *stats = writer->stats;
+    mutex_unlock(&writer->mutex);
+}
@@ -0,0 +1,134 @@
+#include "controller_bridge.h"
+#include "link_stats.h"
+#include <stdio.h>
+#include <string.h>
+
+#define STATS_REPLY_TIMEOUT_US 200000
+#define STATS_RETRIES          3
+
+typedef struct {
+    uint8_t device;
+    bool answered;
+    link_stats_t stats;
+} stats_reply_t;
+
+static void handle_stats_reply(const link_frame_t *frame, void *ctx) {
+    stats_reply_t *reply = (stats_reply_t *)ctx;
+    uint8_t device;
+    link_stats_t stats;
+
+    if (frame->type == LINK_TYPE_STATS &&
+        link_stats_unpack(frame->payload, frame->len, &device, &stats) &&
+        device == reply->device) {
+        reply->stats = stats;
+        reply->answered = true;
+    }
+}
+
+/* Ask one device for its counters; retried if unanswered */
+static bool query(serial_port_t serial, link_encoder_t *link, link_decoder_t *decoder,
+                  uint8_t device, link_stats_t *stats) {
+    uint8_t packet[LINK_ENCODED_SIZE(1)];
+
+    for (int attempt = 0; attempt < STATS_RETRIES; attempt++) {
+        stats_reply_t reply = { .device = device, .answered = false };
+        size_t packet_len = link_encode(link, LINK_TYPE_STATS, &device, 1, packet);
+        if (!serial_write(serial, packet, packet_len)) {
+            return false;
+        }
+
+        uint64_t sent_us = timing_now_us();
+        while (!reply.answered && timing_now_us() - sent_us < STATS_REPLY_TIMEOUT_US) {
+            uint8_t buffer[256];
+            int count = serial_read(serial, buffer, sizeof(buffer));
+            if (count > 0) {
+                link_decoder_feed(decoder, buffer, (size_t)count, handle_stats_reply, &reply);
+            } else {
+                timing_sleep_ms(1);
+            }
+        }
+
+        if (reply.answered) {
+            *stats = reply.stats;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* One line per non-empty bucket, e.g. "  256-511 us     1234" */
+static void print_histogram(const char *title, const uint32_t *hist, uint32_t max_us) {
+    uint64_t total = 0;
+    for (int i = 0; i < LINK_STATS_BUCKETS; i++) {
+        total += hist[i];
+    }
+    printf("  %s: %llu samples, max %lu us\n", title, (unsigned long long)total,
+           (unsigned long)max_us);
+    if (total == 0) {
+        return;
+    }
+
+    for (int i = 0; i < LINK_STATS_BUCKETS; i++) {
+        if (hist[i] == 0) {
+            continue;
+        }
+        char range[32];
+        unsigned long low = i == 0 ? 0 : 1ul << i;
+        if (i == LINK_STATS_BUCKETS - 1) {
+            snprintf(range, sizeof(range), "%lu+ us", low);
+        } else {
+            snprintf(range, sizeof(range), "%lu-%lu us", low, (2ul << i) - 1);
+        }
+        printf("    %-16s %10lu  %5.1f%%\n", range, (unsigned long)hist[i],
+               100.0 * hist[i] / (double)total);
+    }
+}
+
+static void print_stats(const char *name, const link_stats_t *s, bool is_switch) {
+    printf("%s (up %.1f s)\n", name, s->uptime_ms / 1000.0);
+    printf("  Frames:   %lu ok, %lu lost, %lu CRC errors, %lu resyncs\n",
+           (unsigned long)s->frames_ok, (unsigned long)s->frames_lost,
+           (unsigned long)s->crc_errors, (unsigned long)s->resyncs);
+    printf("  Receiver: %lu overruns, %lu ring overflows\n",
+           (unsigned long)s->rx_overruns, (unsigned long)s->ring_overflows);
+    if (is_switch) {
+        printf("  Reports:  %lu sent, %lu waited for the endpoint\n",
+               (unsigned long)s->reports_sent, (unsigned long)s->hid_not_ready);
+    } else {
+        printf("  Forwarded: %lu frames, %lu states coalesced\n",
+               (unsigned long)s->reports_sent, (unsigned long)s->frames_coalesced);
+    }
+    print_histogram("Loop time", s->loop_hist, s->loop_max_us);
+    print_histogram(is_switch ? "Frame to HID report" : "Frame to link", s->latency_hist,
+                    s->latency_max_us);
+    if (is_switch) {
+        printf("  Frame to HID report: last %lu us, avg %lu us\n",
+               (unsigned long)s->latency_last_us, (unsigned long)s->latency_avg_us);
+    }
+    printf("\n");
+}
+
+bool stats_query(serial_port_t serial, link_encoder_t *link, bool direct) {
+    link_decoder_t decoder;
+    link_stats_t stats;
+    bool any = false;
+
+    link_decoder_init(&decoder);
+
+    if (direct) {
+        /* No bridge Pico on the way */
+    } else if (query(serial, link, &decoder, LINK_STATS_BRIDGE, &stats)) {
+        print_stats("Bridge Pico", &stats, false);
+        any = true;
+    } else {
+        fprintf(stderr, "Error: No counters from the bridge Pico\n");
+    }
+
+    if (query(serial, link, &decoder, LINK_STATS_SWITCH, &stats)) {
+        print_stats("Switch Pico", &stats, true);
+        any = true;
+    } else {
+        fprintf(stderr, "Error: No counters from the Switch Pico\n");
+    }
+    return any;
+}
@@ -0,0 +1,229 @@
+#include "controller_bridge.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Clock sync: keep the sample with the shortest round trip */
+#define TIMELINE_SYNC_SAMPLES    8
+#define TIMELINE_SYNC_TIMEOUT_US 100000
+
+/* First step plays this long after the start, leaving time to queue it */
+#define TIMELINE_START_DELAY_US  100000
+
+/* Stay within the Switch Pico's queue (256 entries) and keep the lead short
+ * enough that a clock sync error doesn't accumulate */
+#define TIMELINE_MAX_AHEAD       200
+#define TIMELINE_MAX_AHEAD_US    500000
+
+/* Targets are on the Pico's 32-bit microsecond clock and compared as signed
+ * differences, so a timeline must stay within half its wrap (~35 min) */
+#define TIMELINE_MAX_MS          (30UL * 60 * 1000)
+
+typedef struct {
+    uint32_t time_ms;
+    uint8_t state[LINK_STATE_SIZE];
+} timeline_step_t;
+
+typedef struct {
+    uint32_t token;
+    bool answered;
+    uint32_t pico_us;
+} time_reply_t;
+
+static void handle_time_reply(const link_frame_t *frame, void *ctx) {
+    time_reply_t *reply = (time_reply_t *)ctx;
+
+    if (frame->type == LINK_TYPE_TIME && frame->len >= LINK_TIME_REPLY_SIZE &&
+        link_get_u32(frame->payload) == reply->token) {
+        reply->pico_us = link_get_u32(frame->payload + 4);
+        reply->answered = true;
+    }
+}
+
+/* Find offset such that Pico time = (uint32_t)PC time + offset. Returns false
+ * if the Switch Pico never answered (older firmware or no link). */
+static bool sync_clock(serial_port_t serial, link_encoder_t *link, uint32_t *offset_us) {
+    link_decoder_t decoder;
+    link_decoder_init(&decoder);
+    uint64_t best_rtt_us = UINT64_MAX;
+
+    for (uint32_t i = 0; i < TIMELINE_SYNC_SAMPLES; i++) {
+        time_reply_t reply = { .token = 0x54494D00u | i, .answered = false };
+        uint8_t payload[4];
+        uint8_t packet[LINK_ENCODED_SIZE(4)];
+
+        link_put_u32(payload, reply.token);
+        size_t packet_len = link_encode(link, LINK_TYPE_TIME, payload, sizeof(payload), packet);
+
+        uint64_t sent_us = timing_now_us();
+        if (!serial_write(serial, packet, packet_len)) {
+            return false;
+        }
+
+        uint64_t now_us = sent_us;
+        while (!reply.answered && now_us - sent_us < TIMELINE_SYNC_TIMEOUT_US) {
+            uint8_t buffer[256];
+            int count = serial_read(serial, buffer, sizeof(buffer));
+            if (count > 0) {
+                link_decoder_feed(&decoder, buffer, (size_t)count, handle_time_reply, &reply);
+            } else {
+                timing_sleep_ms(1);
+            }
+            now_us = timing_now_us();
+        }
+
+        /* Assume the reply was stamped halfway through the round trip */
+        uint64_t rtt_us = now_us - sent_us;
+        if (reply.answered && rtt_us < best_rtt_us) {
+            best_rtt_us = rtt_us;
+            *offset_us = reply.pico_us - (uint32_t)(sent_us + rtt_us / 2);
+        }
+    }
+
+    if (best_rtt_us == UINT64_MAX) {
+        return false;
+    }
+    printf("Clock sync: round trip %.2f ms\n", best_rtt_us / 1000.0);
+    return true;
+}
+
+/* One step per line: time_ms buttons hat lx ly rx ry ('#' starts a comment).
+ * Times are relative to the start of playback, must not decrease and stop
+ * at TIMELINE_MAX_MS. */
+static timeline_step_t *load_steps(const char *filename, size_t *count) {
+    FILE *f = fopen(filename, "r");
+    if (!f) {
+        fprintf(stderr, "Error: Could not open timeline file: %s\n", filename);
+        return NULL;
+    }
+
+    timeline_step_t *steps = NULL;
+    size_t capacity = 0;
+    char line[256];
+    int line_number = 0;
+
+    *count = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_number++;
+        line[strcspn(line, "#\r\n")] = '\0';
+
+        /* Buttons may be written in hex (0x...) */
+        long time_ms, buttons, hat, lx, ly, rx, ry;
+        char extra;
+        int fields = sscanf(line, "%ld %li %li %li %li %li %li %c",
+                            &time_ms, &buttons, &hat, &lx, &ly, &rx, &ry, &extra);
+        if (fields <= 0) {
+            continue;  /* Blank or comment */
+        }
+        if (fields != 7 || time_ms < 0 || (unsigned long)time_ms > TIMELINE_MAX_MS ||
+            buttons < 0 || buttons > 0xFFFF || hat < 0 || hat > 0x0F ||
+            lx < 0 || lx > 255 || ly < 0 || ly > 255 || rx < 0 || rx > 255 || ry < 0 || ry > 255 ||
+            (*count > 0 && (uint32_t)time_ms < steps[*count - 1].time_ms)) {
+            fprintf(stderr, "Error: %s:%d: invalid step\n", filename, line_number);
+            free(steps);
+            fclose(f);
+            return NULL;
+        }
+
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            timeline_step_t *grown = realloc(steps, capacity * sizeof(*steps));
+            if (!grown) {
+                free(steps);
+                fclose(f);
+                return NULL;
+            }
+            steps = grown;
+        }
+
+        timeline_step_t *step = &steps[(*count)++];
+        step->time_ms = (uint32_t)time_ms;
+        step->state[0] = (uint8_t)(buttons & 0xFF);
+        step->state[1] = (uint8_t)(buttons >> 8);
+        step->state[2] = (uint8_t)hat;
+        step->state[3] = (uint8_t)lx;
+        step->state[4] = (uint8_t)ly;
+        step->state[5] = (uint8_t)rx;
+        step->state[6] = (uint8_t)ry;
+        step->state[7] = 0x00;
+    }
+
+    fclose(f);
+    if (*count == 0) {
+        fprintf(stderr, "Error: %s has no steps\n", filename);
+    }
+    return steps;
+}
+
+bool timeline_play(serial_port_t serial, link_encoder_t *link, const char *filename,
+                   volatile bool *running) {
+    size_t count;
+    timeline_step_t *steps = load_steps(filename, &count);
+    if (!steps || count == 0) {
+        free(steps);
+        return false;
+    }
+
+    uint32_t offset_us = 0;
+    if (!sync_clock(serial, link, &offset_us)) {
+        fprintf(stderr, "Error: No clock sync reply from the Switch Pico\n");
+        free(steps);
+        return false;
+    }
+
+    uint8_t packet[LINK_MAX_ENCODED];
+    size_t packet_len = link_command_to_packet(link, LINK_CMD_TIMELINE_CLEAR, 0, packet);
+    serial_write(serial, packet, packet_len);
+
+    /* Everything from here on is in Pico time */
+    uint32_t start_us = (uint32_t)timing_now_us() + offset_us + TIMELINE_START_DELAY_US;
+    uint32_t last_us = start_us + steps[count - 1].time_ms * 1000;
+    size_t sent = 0;
+    size_t played = 0;
+
+    printf("Playing %zu steps (%.3f s)...\n", count, steps[count - 1].time_ms / 1000.0);
+
+    while (*running) {
+        uint32_t now_us = (uint32_t)timing_now_us() + offset_us;
+
+        while (played < sent &&
+               (int32_t)(now_us - (start_us + steps[played].time_ms * 1000)) >= 0) {
+            played++;
+        }
+
+        /* Queue steps until we are far enough ahead */
+        while (sent < count && sent - played < TIMELINE_MAX_AHEAD) {
+            uint32_t target_us = start_us + steps[sent].time_ms * 1000;
+            if ((int32_t)(target_us - now_us) > TIMELINE_MAX_AHEAD_US) {
+                break;
+            }
+
+            uint8_t payload[LINK_TIMED_STATE_SIZE];
+            link_put_u32(payload, target_us);
+            memcpy(&payload[4], steps[sent].state, LINK_STATE_SIZE);
+            packet_len = link_encode(link, LINK_TYPE_TIMED_STATE, payload, sizeof(payload), packet);
+            if (!serial_write(serial, packet, packet_len)) {
+                fprintf(stderr, "Error: Serial write failed during playback\n");
+                free(steps);
+                return false;
+            }
+            sent++;
+        }
+
+        if (sent == count && (int32_t)(now_us - last_us) >= 0) {
+            break;
+        }
+        timing_sleep_ms(1);
+    }
+
+    if (!*running) {
+        /* Interrupted: drop whatever is still queued */
+        packet_len = link_command_to_packet(link, LINK_CMD_TIMELINE_CLEAR, 0, packet);
+        serial_write(serial, packet, packet_len);
+    }
+
+    printf("Timeline %s (%zu of %zu steps queued)\n", *running ? "finished" : "stopped",
+           sent, count);
+    free(steps);
+    return true;
+}
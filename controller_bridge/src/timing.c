@@ -0,0 +1,39 @@
+#include "controller_bridge.h"
+
+#ifdef _WIN32
+#include <windows.h>
+
+uint64_t timing_now_us(void) {
+    static LARGE_INTEGER frequency = { 0 };
+    LARGE_INTEGER counter;
+    
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    
+    /* Split to avoid overflowing counter * 1000000 */
+    uint64_t seconds = (uint64_t)(counter.QuadPart / frequency.QuadPart);
+    uint64_t remainder = (uint64_t)(counter.QuadPart % frequency.QuadPart);
+    return seconds * 1000000ULL + remainder * 1000000ULL / (uint64_t)frequency.QuadPart;
+}
+
+void timing_sleep_ms(uint32_t ms) {
+    Sleep(ms);
+}
+
+#else
+#include <time.h>
+#include <unistd.h>
+
+uint64_t timing_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+void timing_sleep_ms(uint32_t ms) {
+    usleep((useconds_t)ms * 1000);
+}
+
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hardware/sync.h"
+#include "link_protocol.h"
+
+// Single-writer, single-reader seqlock carrying the newest acknowledgement
+// from core0 (USB) to core1, which owns the link and sends it upstream.
+// Acks describe the newest frame a report carried, so an ack that is
+// overwritten before core1 picks it up is simply superseded.
+
+typedef struct {
+    volatile uint32_t seq;
+    link_ack_t ack;
+} ack_mailbox_t;
+
+static inline void ack_mailbox_publish(ack_mailbox_t *mb, const link_ack_t *ack)
+{
+    uint32_t seq = mb->seq;
+
+    mb->seq = seq + 1;
+    __dmb();
+    mb->ack = *ack;
+    __dmb();
+    mb->seq = seq + 2;
+}
+
+// Copy the newest ack if it differs from *last_seq
+static inline bool ack_mailbox_read(ack_mailbox_t *mb, link_ack_t *ack, uint32_t *last_seq)
+{
+    uint32_t begin, end;
+
+    do {
+        begin = mb->seq;
+        if (begin == *last_seq) {
+            return false;
+        }
+        if (begin & 1) {
+            continue;
+        }
+        __dmb();
+        *ack = mb->ack;
+        __dmb();
+        end = mb->seq;
+    } while ((begin & 1) || begin != end);
+
+    *last_seq = begin;
+    return true;
+}
@@ -1,4 +1,6 @@
 #include "tusb.h"
+#include "hid_reporter.h"
+#include "output_ring.h"
 
 /**
  * Called when host requests a report (GET_REPORT)
@@ -22,7 +24,7 @@ uint16_t tud_hid_get_report_cb(
 
 /**
  * Called when host sends a report (SET_REPORT)
- * Switch sends handshake/LED/rumble here → ignore safely
+ * Switch sends LED/rumble output reports here → queue them for the PC
  */
 void tud_hid_set_report_cb(
     uint8_t itf,
@@ -31,9 +33,24 @@ void tud_hid_set_report_cb(
     uint8_t const* buffer,
     uint16_t bufsize)
 {
-    (void) itf;
-    (void) report_id;
-    (void) report_type;
-    (void) buffer;
-    (void) bufsize;
+    if (report_type != HID_REPORT_TYPE_OUTPUT) {
+        return;
+    }
+
+    output_ring_push(itf, report_id, buffer, bufsize);
+}
+
+/**
+ * Called when the previous IN report has been sent to the host
+ * Chains the next report immediately if the state changed meanwhile
+ */
+void tud_hid_report_complete_cb(
+    uint8_t itf,
+    uint8_t const* report,
+    uint16_t len)
+{
+    (void) report;
+    (void) len;
+
+    hid_reporter_report_complete(itf);
 }
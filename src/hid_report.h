@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+// Virtual controllers, one HID interface each (1-4, set by CMake)
+#ifndef S2RC_CONTROLLERS
+#define S2RC_CONTROLLERS 1
+#endif
+
+// Button definitions (16 buttons total for Switch Pro Controller)
+// Standard Nintendo Switch HID button order: B, A, Y, X, L, R, ZL, ZR, -, +, LS, RS, Home, Capture
+#define BTN_B       (1 << 0)
+#define BTN_A       (1 << 1)
+#define BTN_Y       (1 << 2)
+#define BTN_X       (1 << 3)
+#define BTN_L       (1 << 4)
+#define BTN_R       (1 << 5)
+#define BTN_ZL      (1 << 6)
+#define BTN_ZR      (1 << 7)
+#define BTN_MINUS   (1 << 8)
+#define BTN_PLUS    (1 << 9)
+#define BTN_LSTICK  (1 << 10)
+#define BTN_RSTICK  (1 << 11)
+#define BTN_HOME    (1 << 12)
+#define BTN_CAPTURE (1 << 13)
+#define BTN_GL      (1 << 14)  // Grip Left / Back Left
+#define BTN_GR      (1 << 15)  // Grip Right / Back Right
+
+// HID input report (also the 8-byte payload of a UART state frame)
+// Byte 0-1: Button state (uint16_t, little endian)
+// Byte 2: Hat switch (D-pad)
+// Byte 3: Left stick X (0-255)
+// Byte 4: Left stick Y (0-255)
+// Byte 5: Right stick X (0-255)
+// Byte 6: Right stick Y (0-255)
+// Byte 7: Vendor byte (unused, set to 0)
+
+typedef struct __attribute__((packed)) {
+    uint16_t buttons;     // 2 bytes: 14 buttons + 2 bits padding
+    uint8_t  hat;         // 1 byte: Hat switch (upper 4 bits) + padding (lower 4 bits)
+    uint8_t  lx;          // Left stick X
+    uint8_t  ly;          // Left stick Y
+    uint8_t  rx;          // Right stick X (Z axis)
+    uint8_t  ry;          // Right stick Y (Rz axis)
+    uint8_t  vendor;      // Vendor specific byte
+} hid_report_t;  // Total: 8 bytes
@@ -0,0 +1,190 @@
+// HID report scheduling: periodic and event-driven reporting on core0
+
+#include "hid_reporter.h"
+#include "hid_report.h"
+#include "link_ingest.h"
+#include "timeline.h"
+#include "macro.h"
+#include "tap_latch.h"
+#include "perf_counters.h"
+
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include <string.h>
+
+// Written by core1 when the PC changes them, read here every pass
+static volatile uint8_t report_interval_ms = REPORT_INTERVAL_DEFAULT_MS;
+static volatile uint8_t report_mode = REPORT_MODE_EVENT;
+
+// One per virtual controller (HID interface)
+typedef struct {
+    hid_report_t current_report;
+    bool report_dirty;                 // Changed since it was last sent
+    bool latency_pending;
+    bool waiting;                      // Due, but the endpoint was busy
+    uint32_t frame_time_us;
+    uint32_t mailbox_seq;
+    absolute_time_t last_report;
+
+    // Newest frame folded into current_report, and whether a report has
+    // carried it yet (which is when it gets acknowledged upstream)
+    report_meta_t newest_frame;
+    bool ack_pending;
+
+    tap_latch_t tap_latch;
+} controller_t;
+
+static controller_t controllers[S2RC_CONTROLLERS];
+
+static bool send_report(uint8_t itf)
+{
+    controller_t *ctl = &controllers[itf];
+
+    if (!tud_hid_n_ready(itf)) {
+        // Counted once per report that had to wait, not per retry
+        if (!ctl->waiting) {
+            perf_counters_hid_not_ready();
+            ctl->waiting = true;
+        }
+        return false;
+    }
+
+    // Taps, macros and turbo act on the report as sent, one step per
+    // report. Macros drive the first controller.
+    hid_report_t report = ctl->current_report;
+    tap_latch_apply(&ctl->tap_latch, &report);
+    if (itf == 0) {
+        macro_apply(&report);
+    }
+
+    tud_hid_n_report(itf, 0, &report, sizeof(report));
+    uint32_t report_us = time_us_32();
+    ctl->last_report = get_absolute_time();
+    ctl->report_dirty = false;
+    ctl->waiting = false;
+    perf_counters_report_sent();
+
+    // One ack mailbox for all controllers: an ack replaced before core1 sent
+    // it is lost, which only costs the PC a latency sample
+    if (ctl->ack_pending) {
+        link_ack_t ack = {
+            .seq = ctl->newest_frame.link_seq,
+            .rx_us = ctl->newest_frame.frame_time_us,
+            .report_us = report_us,
+        };
+        ack_mailbox_publish(&g_ack_mailbox, &ack);
+        ctl->ack_pending = false;
+    }
+
+    if (ctl->latency_pending) {
+        perf_counters_report_latency(ctl->frame_time_us);
+        ctl->latency_pending = false;
+    }
+
+    // Turn off LED after sending
+    gpio_put(PICO_DEFAULT_LED_PIN, 0);
+    return true;
+}
+
+void hid_reporter_init(void)
+{
+    for (int i = 0; i < S2RC_CONTROLLERS; i++) {
+        controller_t *ctl = &controllers[i];
+
+        // Initialize report with neutral state
+        memset(ctl, 0, sizeof(*ctl));
+        ctl->current_report.hat = 0x08;  // Neutral D-pad (GP2040-CE uses 0x08 for SWITCH_HAT_NOTHING)
+        ctl->current_report.lx = 128;    // Center
+        ctl->current_report.ly = 128;
+        ctl->current_report.rx = 128;
+        ctl->current_report.ry = 128;
+
+        ctl->last_report = get_absolute_time();
+        tap_latch_init(&ctl->tap_latch);
+    }
+
+    macro_init();
+}
+
+static void controller_task(uint8_t itf)
+{
+    controller_t *ctl = &controllers[itf];
+    hid_report_t incoming;
+    report_meta_t meta;
+
+    if (report_mailbox_read(&g_report_mailbox[itf], &incoming, &meta, &ctl->mailbox_seq)) {
+        ctl->newest_frame = meta;
+        ctl->ack_pending = true;
+
+        // A press released again before this read still has to be reported
+        bool tapped = tap_latch_note_counts(&ctl->tap_latch, &meta.taps);
+
+        if (tapped || memcmp(&incoming, &ctl->current_report, sizeof(incoming)) != 0) {
+            ctl->current_report = incoming;
+            ctl->report_dirty = true;
+            ctl->latency_pending = true;
+            ctl->frame_time_us = meta.frame_time_us;
+
+            // Blink LED to indicate data received
+            gpio_put(PICO_DEFAULT_LED_PIN, 1);
+        }
+    }
+
+    // Timed states whose moment has come take over from the live state
+    // (timelines drive the first controller)
+    if (itf == 0) {
+        uint32_t now_us = time_us_32();
+        while (timeline_pop_due(now_us, &incoming)) {
+            bool tapped = tap_latch_note_states(&ctl->tap_latch, &ctl->current_report, &incoming);
+            if (tapped || memcmp(&incoming, &ctl->current_report, sizeof(incoming)) != 0) {
+                ctl->current_report = incoming;
+                ctl->report_dirty = true;
+                gpio_put(PICO_DEFAULT_LED_PIN, 1);
+            }
+        }
+    }
+
+    bool due = absolute_time_diff_us(ctl->last_report, get_absolute_time()) >=
+               (int64_t)report_interval_ms * 1000;
+    bool changed = (report_mode == REPORT_MODE_EVENT) && ctl->report_dirty;
+
+    if (due || changed) {
+        send_report(itf);
+    }
+}
+
+void hid_reporter_task(void)
+{
+    for (uint8_t itf = 0; itf < S2RC_CONTROLLERS; itf++) {
+        controller_task(itf);
+    }
+}
+
+void hid_reporter_report_complete(uint8_t itf)
+{
+    // The endpoint just freed up: push a change that arrived while the
+    // previous report was still in flight
+    if (itf < S2RC_CONTROLLERS && report_mode == REPORT_MODE_EVENT &&
+        controllers[itf].report_dirty) {
+        send_report(itf);
+    }
+}
+
+bool hid_reporter_set_interval(uint8_t interval_ms)
+{
+    switch (interval_ms) {
+        case 1:
+        case 2:
+        case 4:
+        case 8:
+            report_interval_ms = interval_ms;
+            return true;
+        default:
+            return false;
+    }
+}
+
+void hid_reporter_set_mode(report_mode_t mode)
+{
+    report_mode = (mode == REPORT_MODE_PERIODIC) ? REPORT_MODE_PERIODIC : REPORT_MODE_EVENT;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// HID report scheduling (runs on core0)
+//
+// Every report_interval_ms the current report is sent to the console. In
+// event mode a report is additionally queued the moment a changed frame is
+// decoded; if the IN endpoint is still busy, the send is chained from
+// tud_hid_report_complete_cb instead of waiting for the next tick.
+//
+// Every report that carries a newer link frame is acknowledged upstream
+// with the frame's receive time and the report time (see link_ack_t).
+//
+// Each virtual controller has its own HID interface, report and schedule;
+// the interval and mode apply to all of them.
+
+#define REPORT_INTERVAL_DEFAULT_MS 8
+
+typedef enum {
+    REPORT_MODE_PERIODIC = 0,  // Only send on interval ticks
+    REPORT_MODE_EVENT = 1,     // Also send as soon as the report changes
+} report_mode_t;
+
+void hid_reporter_init(void);
+
+// Pull the newest report from core1 and send whatever is due
+void hid_reporter_task(void);
+
+// Called from tud_hid_report_complete_cb once the previous report on an
+// interface was taken
+void hid_reporter_report_complete(uint8_t itf);
+
+// Runtime settings, safe to call from either core. Intervals other than
+// 1, 2, 4 or 8 ms are ignored; returns false in that case.
+bool hid_reporter_set_interval(uint8_t interval_ms);
+void hid_reporter_set_mode(report_mode_t mode);
@@ -0,0 +1,267 @@
+// Link ingest: UART framing and decoding on core1
+
+#include "link_ingest.h"
+#include "link_transport.h"
+#include "hid_reporter.h"
+#include "link_baud.h"
+#include "timeline.h"
+#include "macro.h"
+#include "macro_store.h"
+#include "tap_latch.h"
+#include "output_ring.h"
+#include "perf_counters.h"
+
+#include "pico/stdlib.h"
+
+report_mailbox_t g_report_mailbox[S2RC_CONTROLLERS] = {0};
+ack_mailbox_t g_ack_mailbox = {0};
+
+static link_decoder_t decoder;
+static link_encoder_t encoder;
+static link_baud_slave_t baud_slave;
+static tap_counts_t tap_counts[S2RC_CONTROLLERS];
+static link_delta_t delta_rx[S2RC_CONTROLLERS];
+
+typedef struct {
+    hid_report_t *reports;
+    uint8_t link_seq[S2RC_CONTROLLERS];
+    uint8_t updated;                  // Bit per controller
+} ingest_ctx_t;
+
+static void handle_command(uint8_t command, uint8_t value)
+{
+    switch (command) {
+        case LINK_CMD_REPORT_INTERVAL:
+            hid_reporter_set_interval(value);
+            break;
+
+        case LINK_CMD_REPORT_MODE:
+            hid_reporter_set_mode(value ? REPORT_MODE_EVENT : REPORT_MODE_PERIODIC);
+            break;
+
+        case LINK_CMD_TIMELINE_CLEAR:
+            timeline_clear();
+            break;
+
+        case LINK_CMD_MACRO_RUN:
+            macro_run(value);
+            break;
+
+        case LINK_CMD_MACRO_STOP:
+            macro_stop();
+            break;
+
+        case LINK_CMD_TAP_HOLD:
+            tap_latch_set_min_hold(value);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void link_send(void *ctx, uint8_t type, const uint8_t *payload, size_t len)
+{
+    (void)ctx;
+    uint8_t packet[LINK_MAX_ENCODED];
+    size_t packet_len = link_encode(&encoder, type, payload, len, packet);
+    link_transport_write(packet, packet_len);
+}
+
+static void link_set_baud(void *ctx, uint32_t baud)
+{
+    (void)ctx;
+    link_transport_set_baud(baud);
+}
+
+// Core0 counters completed with the link counters kept on this core
+static void send_stats(void)
+{
+    link_stats_t stats;
+    link_transport_stats_t transport;
+    uint8_t reply[LINK_STATS_REPLY_SIZE];
+
+    perf_counters_snapshot(&stats);
+    link_transport_get_stats(&transport);
+    stats.frames_ok = decoder.stats.frames_ok;
+    stats.frames_lost = decoder.stats.frames_lost;
+    stats.crc_errors = decoder.stats.crc_errors;
+    stats.resyncs = decoder.stats.resyncs;
+    stats.rx_overruns = transport.rx_overruns;
+    stats.ring_overflows = transport.ring_overflows;
+
+    link_stats_pack(LINK_STATS_SWITCH, &stats, reply);
+    link_send(NULL, LINK_TYPE_STATS, reply, sizeof(reply));
+}
+
+static uint32_t now_ms(void)
+{
+    return to_ms_since_boot(get_absolute_time());
+}
+
+static void unpack_state(const uint8_t *p, hid_report_t *report)
+{
+    report->buttons = p[0] | (p[1] << 8);
+    // HAT switch is in lower 4 bits (descriptor: HAT first, then padding)
+    report->hat = p[2];
+    report->lx = p[3];
+    report->ly = p[4];
+    report->rx = p[5];
+    report->ry = p[6];
+    report->vendor = p[7];
+}
+
+// Called by the decoder for every frame that passed its CRC check
+static void handle_frame(const link_frame_t *frame, void *ctx)
+{
+    ingest_ctx_t *ingest = (ingest_ctx_t *)ctx;
+    const uint8_t *p = frame->payload;
+
+    if (link_baud_slave_handle_frame(&baud_slave, frame, now_ms())) {
+        return;
+    }
+
+    switch (frame->type) {
+        case LINK_TYPE_STATE:
+        case LINK_TYPE_DELTA: {
+            // Keyframes and deltas both land in the controller's delta_rx.
+            // Frames for controllers this build doesn't have are dropped.
+            uint8_t id = link_state_controller(frame);
+            if (id >= S2RC_CONTROLLERS ||
+                !link_delta_decode(&delta_rx[id], frame, &decoder.stats)) {
+                break;
+            }
+            hid_report_t *report = &ingest->reports[id];
+            hid_report_t before = *report;
+            unpack_state(delta_rx[id].state, report);
+            tap_counts_update(&tap_counts[id], &before, report);
+            ingest->link_seq[id] = frame->seq;
+            ingest->updated |= (uint8_t)(1u << id);
+            break;
+        }
+
+        case LINK_TYPE_TIMED_STATE:
+            if (frame->len >= LINK_TIMED_STATE_SIZE) {
+                hid_report_t timed = {0};
+                unpack_state(&p[4], &timed);
+                timeline_push(link_get_u32(p), &timed);
+            }
+            break;
+
+        case LINK_TYPE_TIME:
+            // Echo the token with our clock so the PC can map its time to ours
+            if (frame->len >= 4) {
+                uint8_t reply[LINK_TIME_REPLY_SIZE];
+                reply[0] = p[0];
+                reply[1] = p[1];
+                reply[2] = p[2];
+                reply[3] = p[3];
+                link_put_u32(&reply[4], time_us_32());
+                link_send(NULL, LINK_TYPE_TIME, reply, sizeof(reply));
+            }
+            break;
+
+        case LINK_TYPE_COMMAND:
+            if (frame->len >= 2) {
+                handle_command(p[0], p[1]);
+            }
+            break;
+
+        case LINK_TYPE_MACRO:
+            if (frame->len >= 1) {
+                uint8_t reply[2] = { p[0], macro_store_handle_upload(p, frame->len) };
+                link_send(NULL, LINK_TYPE_MACRO, reply, sizeof(reply));
+            }
+            break;
+
+        case LINK_TYPE_STATS:
+            if (frame->len >= 1 && p[0] == LINK_STATS_SWITCH) {
+                send_stats();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void link_ingest_get_stats(link_rx_stats_t *stats)
+{
+    *stats = decoder.stats;
+}
+
+void link_ingest_core1_main(void)
+{
+    // The transport's DMA IRQ is installed on this core
+    link_transport_init();
+
+    link_decoder_init(&decoder);
+    link_encoder_init(&encoder);
+    for (int i = 0; i < S2RC_CONTROLLERS; i++) {
+        link_delta_init(&delta_rx[i], LINK_DELTA_KEYFRAME_DEFAULT);
+    }
+
+    const link_baud_ops_t baud_ops = {
+        .set_baud = link_set_baud,
+        .send = link_send,
+        .ctx = NULL,
+    };
+    link_baud_slave_init(&baud_slave, &baud_ops, now_ms());
+
+    // Initialize reports with neutral state
+    hid_report_t reports[S2RC_CONTROLLERS] = {0};
+    for (int i = 0; i < S2RC_CONTROLLERS; i++) {
+        reports[i].hat = 0x08;  // Neutral D-pad (GP2040-CE uses 0x08 for SWITCH_HAT_NOTHING)
+        reports[i].lx = 128;    // Center
+        reports[i].ly = 128;
+        reports[i].rx = 128;
+        reports[i].ry = 128;
+    }
+
+    uint32_t ack_seq = 0;
+
+    while (true) {
+        const uint8_t *chunk;
+        size_t chunk_len;
+
+        while ((chunk_len = link_transport_peek(&chunk)) > 0) {
+            uint32_t frame_time_us = time_us_32();
+
+            ingest_ctx_t ctx = { .reports = reports, .updated = 0 };
+
+            link_decoder_feed(&decoder, chunk, chunk_len, handle_frame, &ctx);
+            for (int i = 0; i < S2RC_CONTROLLERS; i++) {
+                if (ctx.updated & (1u << i)) {
+                    report_meta_t meta = {
+                        .frame_time_us = frame_time_us,
+                        .link_seq = ctx.link_seq[i],
+                        .taps = tap_counts[i],
+                    };
+                    report_mailbox_publish(&g_report_mailbox[i], &reports[i], &meta);
+                }
+            }
+            link_transport_consume(chunk_len);
+        }
+
+        // Tell the bridge which frame the last HID report carried
+        link_ack_t ack;
+        if (ack_mailbox_read(&g_ack_mailbox, &ack, &ack_seq)) {
+            uint8_t payload[LINK_ACK_SIZE];
+            link_ack_pack(&ack, payload);
+            link_send(NULL, LINK_TYPE_ACK, payload, sizeof(payload));
+        }
+
+        // Forward what the console sent the controllers (rumble, LEDs)
+        link_output_t output;
+        while (output_ring_pop(&output)) {
+            uint8_t payload[LINK_OUTPUT_HEADER_SIZE + LINK_OUTPUT_MAX_DATA];
+            size_t len = link_output_pack(&output, payload);
+            link_send(NULL, LINK_TYPE_OUTPUT, payload, len);
+        }
+
+        // Fall back to the base rate if the link went quiet or noisy
+        link_baud_slave_poll(&baud_slave, now_ms(), &decoder.stats);
+
+        tight_loop_contents();
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "report_mailbox.h"
+#include "ack_mailbox.h"
+#include "link_protocol.h"
+
+// Link ingest (runs on core1)
+//
+// Owns the link transport: drains the DMA receive ring, decodes frames (see
+// common/link_protocol.h) and publishes the newest report of every virtual
+// controller to its mailbox, read by core0. Acks and console output reports
+// posted by core0 are sent back upstream from here.
+
+extern report_mailbox_t g_report_mailbox[S2RC_CONTROLLERS];
+extern ack_mailbox_t g_ack_mailbox;
+
+// Core1 entry point; never returns
+void link_ingest_core1_main(void);
+
+// Snapshot of the frame loss / corruption / resync counters
+void link_ingest_get_stats(link_rx_stats_t *stats);
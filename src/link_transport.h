@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Inter-Pico link transport (Switch Pico side)
+//
+// Bytes arriving from the bridge Pico are written by DMA into a circular
+// buffer, so the hardware FIFO is drained even while the CPU is busy inside
+// tud_task(). The consumer peeks at the largest contiguous chunk available,
+// parses it, then consumes it.
+//
+// Two implementations, selected with LINK_TRANSPORT at configure time:
+//   link_transport_uart.c - UART on GP0/GP1 (default)
+//   link_transport_pio.c  - clocked synchronous link (common/link_sync.pio)
+
+typedef struct {
+    uint32_t rx_bytes;        // Bytes handed to the parser
+    uint32_t rx_overruns;     // Receiver FIFO overruns (UART OE, PIO RX stall)
+    uint32_t ring_overflows;  // Times the DMA writer lapped the consumer
+    uint32_t dropped_bytes;   // Bytes discarded because of ring overflows
+} link_transport_stats_t;
+
+// Configure pins, the link peripheral and the RX DMA channel. The DMA
+// completion IRQ is installed on the calling core.
+void link_transport_init(void);
+
+// Return the number of contiguous bytes ready to parse and point *data at
+// them. Returns 0 when the ring is empty.
+size_t link_transport_peek(const uint8_t **data);
+
+// Release len bytes previously returned by link_transport_peek()
+void link_transport_consume(size_t len);
+
+void link_transport_get_stats(link_transport_stats_t *stats);
+
+// Blocking transmit towards the bridge Pico (core1 only)
+void link_transport_write(const uint8_t *data, size_t len);
+
+// Change the link rate once pending TX has drained (no-op on the clocked
+// PIO link, which runs at a fixed bit rate)
+void link_transport_set_baud(uint32_t baud);
@@ -0,0 +1,95 @@
+// Clocked synchronous link transport driven by PIO and DMA
+//
+// Two PIO state machines run the programs in common/link_sync.pio: one
+// clocks bytes out, one samples the bridge Pico's clock. Received bytes go
+// through the same DMA ring as the UART transport and transmitted frames are
+// handed to a DMA channel, so the CPU only touches whole frames.
+
+#include "link_transport.h"
+#include "link_rx_ring.h"
+#include "link_sync.pio.h"
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include <string.h>
+
+#define LINK_PIO pio1
+
+static uint tx_sm;
+static uint rx_sm;
+static int tx_dma_chan = -1;
+static uint8_t tx_buffer[256];
+static link_transport_stats_t stats = {0};
+
+void link_transport_init(void)
+{
+    tx_sm = (uint)pio_claim_unused_sm(LINK_PIO, true);
+    rx_sm = (uint)pio_claim_unused_sm(LINK_PIO, true);
+
+    uint tx_offset = pio_add_program(LINK_PIO, &link_sync_tx_program);
+    uint rx_offset = pio_add_program(LINK_PIO, &link_sync_rx_program);
+    link_sync_tx_program_init(LINK_PIO, tx_sm, tx_offset, LINK_SYNC_TX_PIN, LINK_SYNC_BIT_RATE);
+    link_sync_rx_program_init(LINK_PIO, rx_sm, rx_offset, LINK_SYNC_RX_PIN);
+
+    // Byte-wide writes to the TX FIFO are replicated across the word, which
+    // puts each byte where the program shifts from (bits 31..24)
+    tx_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config cfg = dma_channel_get_default_config(tx_dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, pio_get_dreq(LINK_PIO, tx_sm, true));
+    dma_channel_configure(tx_dma_chan, &cfg, &LINK_PIO->txf[tx_sm], tx_buffer, 0, false);
+
+    link_rx_ring_init(pio_get_dreq(LINK_PIO, rx_sm, false), &LINK_PIO->rxf[rx_sm]);
+}
+
+size_t link_transport_peek(const uint8_t **data)
+{
+    // Sticky stall flag: the RX FIFO was full when a byte completed
+    uint32_t rx_stall = 1u << (PIO_FDEBUG_RXSTALL_LSB + rx_sm);
+    if (LINK_PIO->fdebug & rx_stall) {
+        LINK_PIO->fdebug = rx_stall;
+        stats.rx_overruns++;
+    }
+
+    return link_rx_ring_peek(data);
+}
+
+void link_transport_consume(size_t len)
+{
+    link_rx_ring_consume(len);
+    stats.rx_bytes += len;
+}
+
+void link_transport_get_stats(link_transport_stats_t *out)
+{
+    link_rx_ring_stats_t ring;
+    link_rx_ring_get_stats(&ring);
+
+    *out = stats;
+    out->ring_overflows = ring.ring_overflows;
+    out->dropped_bytes = ring.dropped_bytes;
+}
+
+void link_transport_write(const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        size_t chunk = len < sizeof(tx_buffer) ? len : sizeof(tx_buffer);
+
+        // The previous frame may still be going out of the buffer
+        dma_channel_wait_for_finish_blocking(tx_dma_chan);
+        memcpy(tx_buffer, data, chunk);
+        dma_channel_transfer_from_buffer_now(tx_dma_chan, tx_buffer, chunk);
+
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+void link_transport_set_baud(uint32_t baud)
+{
+    // Fixed bit rate; the bridge never negotiates on this link
+    (void)baud;
+}
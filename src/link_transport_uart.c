@@ -0,0 +1,73 @@
+// UART link transport with a DMA-driven receive ring
+//
+// Received bytes are copied by DMA into the ring in common/link_rx_ring.c,
+// so the UART FIFO is drained without CPU involvement.
+
+#include "link_transport.h"
+#include "link_rx_ring.h"
+#include "link_baud.h"
+
+#include "pico/stdlib.h"
+#include "hardware/uart.h"
+
+// UART Configuration
+#define UART_ID uart0
+#define UART_TX_PIN 0
+#define UART_RX_PIN 1
+#define UART_BAUD_RATE LINK_BAUD_BASE  // Until negotiated up, see link_baud.h
+
+static link_transport_stats_t stats = {0};
+
+void link_transport_init(void)
+{
+    // Initialize UART on GP0 (TX) and GP1 (RX)
+    uart_init(UART_ID, UART_BAUD_RATE);
+    gpio_set_function(UART_TX_PIN, GPIO_FUNC_UART);
+    gpio_set_function(UART_RX_PIN, GPIO_FUNC_UART);
+
+    // Enable UART FIFO (DMA requests are raised per byte either way)
+    uart_set_fifo_enabled(UART_ID, true);
+
+    link_rx_ring_init(uart_get_dreq(UART_ID, false), &uart_get_hw(UART_ID)->dr);
+}
+
+size_t link_transport_peek(const uint8_t **data)
+{
+    // Sticky overrun flag: the FIFO filled before DMA could drain it
+    uart_hw_t *hw = uart_get_hw(UART_ID);
+    if (hw->rsr & UART_UARTRSR_OE_BITS) {
+        hw->rsr = UART_UARTRSR_OE_BITS;
+        stats.rx_overruns++;
+    }
+
+    return link_rx_ring_peek(data);
+}
+
+void link_transport_consume(size_t len)
+{
+    link_rx_ring_consume(len);
+    stats.rx_bytes += len;
+}
+
+void link_transport_get_stats(link_transport_stats_t *out)
+{
+    link_rx_ring_stats_t ring;
+    link_rx_ring_get_stats(&ring);
+
+    *out = stats;
+    out->ring_overflows = ring.ring_overflows;
+    out->dropped_bytes = ring.dropped_bytes;
+}
+
+void link_transport_write(const uint8_t *data, size_t len)
+{
+    uart_write_blocking(UART_ID, data, len);
+}
+
+void link_transport_set_baud(uint32_t baud)
+{
+    // Let the last frame (the baud acknowledgement) leave at the old rate;
+    // the RX DMA keeps running across the divisor change
+    uart_tx_wait_blocking(UART_ID);
+    uart_set_baudrate(UART_ID, baud);
+}
@@ -0,0 +1,244 @@
+// Macro engine: bytecode interpreter stepped once per HID report
+
+#include "macro.h"
+#include "macro_store.h"
+#include "link_macro.h"
+
+#include "pico/stdlib.h"
+#include <string.h>
+
+// Instructions executed per report at most, so a loop without HOLD or WAIT
+// cannot stall the USB task
+#define MACRO_STEP_BUDGET 64
+
+#define MACRO_REQUEST_STOP 0xFF
+
+typedef struct {
+    uint16_t start;       // First instruction of the body
+    uint8_t remaining;    // Passes left, 0 = forever
+} macro_loop_t;
+
+typedef struct {
+    bool running;
+    uint16_t pc;
+    uint16_t pressed;
+    uint16_t tapped;      // Pressed during this step, even if released again
+    uint8_t hold;         // Further reports to keep the current state for
+    bool waiting;
+    uint32_t wait_until_us;
+    macro_loop_t loops[LINK_MACRO_MAX_DEPTH];
+    uint8_t depth;
+    uint16_t turbo_mask;
+    uint8_t turbo_period;
+    uint8_t turbo_count;
+    bool turbo_off;       // In the released half of the turbo cycle
+} macro_vm_t;
+
+static uint8_t image[LINK_MACRO_IMAGE_MAX];
+static size_t image_len = 0;
+static uint32_t image_generation = 0;
+static macro_vm_t vm;
+
+// Written by core1: request counter in bits 8..31, slot (or STOP) in 0..7
+static volatile uint32_t request = 0;
+static uint32_t request_seen = 0;
+
+static void load_image(void)
+{
+    image_generation = macro_store_generation();
+    image_len = macro_image_check(macro_store_image(), LINK_MACRO_IMAGE_MAX);
+    memcpy(image, macro_store_image(), image_len);
+}
+
+static void vm_reset(void)
+{
+    memset(&vm, 0, sizeof(vm));
+}
+
+static void vm_start(uint8_t slot)
+{
+    uint16_t turbo_mask = vm.turbo_mask;
+    uint8_t turbo_period = vm.turbo_period;
+
+    vm_reset();
+    vm.turbo_mask = turbo_mask;  // Turbo outlives the macro that set it
+    vm.turbo_period = turbo_period;
+
+    if (slot >= LINK_MACRO_SLOTS || image_len == 0) {
+        return;
+    }
+    uint16_t offset = image[8 + 2 * slot] | (image[9 + 2 * slot] << 8);
+    if (offset == LINK_MACRO_NO_SLOT || offset < LINK_MACRO_HEADER_SIZE || offset >= image_len) {
+        return;
+    }
+    vm.pc = offset;
+    vm.running = true;
+}
+
+static void vm_end(void)
+{
+    vm.running = false;
+    vm.pressed = 0;
+}
+
+// Operand fetch; a truncated instruction ends the macro
+static bool fetch(uint16_t count, const uint8_t **operands)
+{
+    if ((size_t)vm.pc + 1 + count > image_len) {
+        vm_end();
+        return false;
+    }
+    *operands = &image[vm.pc + 1];
+    vm.pc += 1 + count;
+    return true;
+}
+
+static void vm_step(uint32_t now_us)
+{
+    if (vm.hold > 0) {
+        vm.hold--;
+        return;
+    }
+    if (vm.waiting) {
+        if ((int32_t)(now_us - vm.wait_until_us) < 0) {
+            return;
+        }
+        vm.waiting = false;
+    }
+
+    for (int budget = MACRO_STEP_BUDGET; vm.running && budget > 0; budget--) {
+        const uint8_t *arg;
+
+        if (vm.pc >= image_len) {
+            vm_end();
+            return;
+        }
+
+        switch (image[vm.pc]) {
+            case LINK_MACRO_OP_END:
+                vm_end();
+                return;
+
+            case LINK_MACRO_OP_PRESS:
+                if (fetch(2, &arg)) {
+                    vm.pressed |= arg[0] | (arg[1] << 8);
+                    vm.tapped |= arg[0] | (arg[1] << 8);
+                }
+                break;
+
+            case LINK_MACRO_OP_RELEASE:
+                if (fetch(2, &arg)) {
+                    vm.pressed &= ~(arg[0] | (arg[1] << 8));
+                }
+                break;
+
+            case LINK_MACRO_OP_HOLD:
+                if (fetch(1, &arg) && arg[0] > 0) {
+                    // This report is the first of the n
+                    vm.hold = arg[0] - 1;
+                    return;
+                }
+                break;
+
+            case LINK_MACRO_OP_WAIT:
+                if (fetch(2, &arg)) {
+                    vm.wait_until_us = now_us + (uint32_t)(arg[0] | (arg[1] << 8)) * 1000;
+                    vm.waiting = true;
+                    return;
+                }
+                break;
+
+            case LINK_MACRO_OP_LOOP:
+                if (fetch(1, &arg)) {
+                    if (vm.depth >= LINK_MACRO_MAX_DEPTH) {
+                        vm_end();
+                        return;
+                    }
+                    vm.loops[vm.depth].start = vm.pc;
+                    vm.loops[vm.depth].remaining = arg[0];
+                    vm.depth++;
+                }
+                break;
+
+            case LINK_MACRO_OP_NEXT: {
+                vm.pc++;
+                if (vm.depth == 0) {
+                    break;  // Stray NEXT: ignore
+                }
+                macro_loop_t *loop = &vm.loops[vm.depth - 1];
+                if (loop->remaining == 0 || --loop->remaining > 0) {
+                    vm.pc = loop->start;
+                } else {
+                    vm.depth--;
+                }
+                break;
+            }
+
+            case LINK_MACRO_OP_TURBO:
+                if (fetch(3, &arg)) {
+                    vm.turbo_mask ^= arg[0] | (arg[1] << 8);
+                    vm.turbo_period = arg[2] ? arg[2] : 1;
+                    vm.turbo_count = 0;
+                    vm.turbo_off = false;
+                }
+                break;
+
+            default:
+                vm_end();  // Unknown instruction
+                return;
+        }
+    }
+}
+
+void macro_init(void)
+{
+    load_image();
+    vm_reset();
+}
+
+void macro_run(uint8_t slot)
+{
+    request = ((request + 0x100) & ~0xFFu) | slot;
+}
+
+void macro_stop(void)
+{
+    macro_run(MACRO_REQUEST_STOP);
+}
+
+void macro_apply(hid_report_t *report)
+{
+    // A new image was committed: the old bytecode is gone
+    if (image_generation != macro_store_generation()) {
+        load_image();
+        vm_reset();
+    }
+
+    uint32_t req = request;
+    if (req != request_seen) {
+        request_seen = req;
+        uint8_t slot = req & 0xFF;
+        if (slot == MACRO_REQUEST_STOP) {
+            vm_reset();
+        } else {
+            vm_start(slot);
+        }
+    }
+
+    if (vm.running) {
+        vm_step(time_us_32());
+    }
+
+    report->buttons |= vm.pressed | vm.tapped;
+    vm.tapped = 0;
+
+    if (vm.turbo_mask != 0) {
+        if (vm.turbo_off) {
+            report->buttons &= ~vm.turbo_mask;
+        }
+        if (++vm.turbo_count >= vm.turbo_period) {
+            vm.turbo_count = 0;
+            vm.turbo_off = !vm.turbo_off;
+        }
+    }
+}
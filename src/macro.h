@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hid_report.h"
+
+// Macro engine (runs on core0)
+//
+// Executes the bytecode described in common/link_macro.h, one step per HID
+// report, from a RAM copy of the stored image. Buttons the macro presses
+// are added to the report built from the PC's input; turbo buttons blink
+// on top of both.
+
+void macro_init(void);
+
+// Requests from core1; taken up with the next report
+void macro_run(uint8_t slot);
+void macro_stop(void);
+
+// Advance the running macro by one report and apply it to report. Call
+// exactly once for every report sent.
+void macro_apply(hid_report_t *report);
@@ -0,0 +1,108 @@
+// Macro image storage: RAM staging on core1, one flash sector
+
+#include "macro_store.h"
+#include "link_protocol.h"
+
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include <string.h>
+
+#define FLASH_ENTER_EXIT_TIMEOUT_MS 100
+
+static uint8_t staging[FLASH_SECTOR_SIZE];
+static size_t staging_len = 0;
+static volatile uint32_t generation = 0;
+
+size_t macro_image_check(const uint8_t *image, size_t max_len)
+{
+    if (max_len < LINK_MACRO_HEADER_SIZE || link_get_u32(image) != LINK_MACRO_MAGIC) {
+        return 0;
+    }
+
+    size_t len = image[4] | (image[5] << 8);
+    uint16_t crc = image[6] | (image[7] << 8);
+    if (len < LINK_MACRO_HEADER_SIZE || len > max_len ||
+        link_crc16(&image[LINK_MACRO_HEADER_SIZE], len - LINK_MACRO_HEADER_SIZE) != crc) {
+        return 0;
+    }
+    return len;
+}
+
+const uint8_t *macro_store_image(void)
+{
+    return (const uint8_t *)(XIP_BASE + MACRO_FLASH_OFFSET);
+}
+
+uint32_t macro_store_generation(void)
+{
+    return generation;
+}
+
+// Runs with core0 parked and interrupts off
+static void program_sector(void *param)
+{
+    (void)param;
+    flash_range_erase(MACRO_FLASH_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(MACRO_FLASH_OFFSET, staging, FLASH_SECTOR_SIZE);
+}
+
+static uint8_t commit(void)
+{
+    if (macro_image_check(staging, staging_len) != staging_len) {
+        return LINK_MACRO_STATUS_BAD_IMAGE;
+    }
+
+    // Pad the sector so stale bytes never follow the image
+    memset(&staging[staging_len], 0xFF, sizeof(staging) - staging_len);
+
+    if (flash_safe_execute(program_sector, NULL, FLASH_ENTER_EXIT_TIMEOUT_MS) != PICO_OK ||
+        memcmp(macro_store_image(), staging, staging_len) != 0) {
+        return LINK_MACRO_STATUS_FLASH;
+    }
+
+    // Staging is kept so a COMMIT retried after a lost reply succeeds again
+    generation++;
+    return LINK_MACRO_STATUS_OK;
+}
+
+uint8_t macro_store_handle_upload(const uint8_t *payload, size_t len)
+{
+    if (len < 1) {
+        return LINK_MACRO_STATUS_BAD_ARGS;
+    }
+
+    switch (payload[0]) {
+        case LINK_MACRO_UPLOAD_BEGIN: {
+            if (len < 3) {
+                return LINK_MACRO_STATUS_BAD_ARGS;
+            }
+            size_t image_len = payload[1] | (payload[2] << 8);
+            if (image_len < LINK_MACRO_HEADER_SIZE || image_len > LINK_MACRO_IMAGE_MAX) {
+                return LINK_MACRO_STATUS_BAD_ARGS;
+            }
+            memset(staging, 0xFF, sizeof(staging));
+            staging_len = image_len;
+            return LINK_MACRO_STATUS_OK;
+        }
+
+        case LINK_MACRO_UPLOAD_DATA: {
+            if (len < 3) {
+                return LINK_MACRO_STATUS_BAD_ARGS;
+            }
+            size_t offset = payload[1] | (payload[2] << 8);
+            size_t count = len - 3;
+            if (count > LINK_MACRO_CHUNK_MAX || offset + count > staging_len) {
+                return LINK_MACRO_STATUS_BAD_ARGS;
+            }
+            memcpy(&staging[offset], &payload[3], count);
+            return LINK_MACRO_STATUS_OK;
+        }
+
+        case LINK_MACRO_UPLOAD_COMMIT:
+            return commit();
+
+        default:
+            return LINK_MACRO_STATUS_BAD_ARGS;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "link_macro.h"
+
+// Macro image storage (see common/link_macro.h)
+//
+// The image lives in the last flash sector. Uploads are staged in RAM on
+// core1 and written on COMMIT with flash_safe_execute, which parks core0
+// for the ~50 ms the erase takes. Link bytes arriving meanwhile may be
+// dropped; the PC waits for the COMMIT reply before sending more.
+
+#define MACRO_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+
+// Returns the image length if it is a well-formed image, 0 otherwise
+size_t macro_image_check(const uint8_t *image, size_t max_len);
+
+// The stored image, read directly from flash (may not be valid)
+const uint8_t *macro_store_image(void);
+
+// Advances after every successful commit
+uint32_t macro_store_generation(void);
+
+// Handle one LINK_TYPE_MACRO request (core1); returns LINK_MACRO_STATUS_*
+uint8_t macro_store_handle_upload(const uint8_t *payload, size_t len);
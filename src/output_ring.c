@@ -0,0 +1,57 @@
+// Output reports from the console: single-producer, single-consumer ring
+
+#include "output_ring.h"
+
+#include "hardware/sync.h"
+#include <string.h>
+
+#define OUTPUT_RING_MASK (OUTPUT_RING_DEPTH - 1)
+
+static link_output_t entries[OUTPUT_RING_DEPTH];
+static volatile uint32_t head = 0;   // Next entry to pop, written by core1
+static volatile uint32_t tail = 0;   // Next free slot, written by core0
+static output_ring_stats_t stats = {0};
+
+bool output_ring_push(uint8_t controller, uint8_t report_id, const uint8_t *data, uint16_t len)
+{
+    uint32_t t = tail;
+
+    if (t - head >= OUTPUT_RING_DEPTH) {
+        stats.overflows++;
+        return false;
+    }
+    if (len > LINK_OUTPUT_MAX_DATA) {
+        len = LINK_OUTPUT_MAX_DATA;
+    }
+
+    link_output_t *entry = &entries[t & OUTPUT_RING_MASK];
+    entry->controller = controller;
+    entry->report_id = report_id;
+    entry->len = (uint8_t)len;
+    memcpy(entry->data, data, len);
+    __dmb();
+    tail = t + 1;
+    stats.queued++;
+    return true;
+}
+
+bool output_ring_pop(link_output_t *output)
+{
+    uint32_t h = head;
+
+    if (h == tail) {
+        return false;
+    }
+    __dmb();
+
+    *output = entries[h & OUTPUT_RING_MASK];
+
+    __dmb();
+    head = h + 1;
+    return true;
+}
+
+void output_ring_get_stats(output_ring_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "link_protocol.h"
+
+// Output reports from the console (core0 -> core1)
+//
+// The console sends rumble and player LED data to a controller with HID
+// SET_REPORT, which TinyUSB hands to tud_hid_set_report_cb on core0. The
+// callback queues a copy here; core1, which owns the link, sends each one
+// upstream as a LINK_TYPE_OUTPUT frame on its next pass, well under a
+// millisecond later.
+
+#define OUTPUT_RING_DEPTH 16  // Power of two
+
+typedef struct {
+    uint32_t queued;
+    uint32_t overflows;  // Dropped because core1 fell behind
+} output_ring_stats_t;
+
+// Producer (core0). Data beyond LINK_OUTPUT_MAX_DATA is cut off; returns
+// false if the ring is full.
+bool output_ring_push(uint8_t controller, uint8_t report_id, const uint8_t *data, uint16_t len);
+
+// Consumer (core1): take the oldest report, if any
+bool output_ring_pop(link_output_t *output);
+
+void output_ring_get_stats(output_ring_stats_t *stats);
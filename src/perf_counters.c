@@ -0,0 +1,51 @@
+// Performance counters: loop time, HID reports and frame-to-report latency
+
+#include "perf_counters.h"
+
+#include "pico/stdlib.h"
+#include <string.h>
+
+static link_stats_t counters = {0};
+static uint32_t last_loop_us = 0;
+static uint64_t latency_total_us = 0;
+static uint32_t latency_samples = 0;
+
+void perf_counters_loop(void)
+{
+    uint32_t now_us = time_us_32();
+
+    if (last_loop_us != 0) {
+        link_stats_hist_add(counters.loop_hist, &counters.loop_max_us, now_us - last_loop_us);
+    }
+    last_loop_us = now_us;
+}
+
+void perf_counters_report_sent(void)
+{
+    counters.reports_sent++;
+}
+
+void perf_counters_report_latency(uint32_t frame_time_us)
+{
+    uint32_t us = time_us_32() - frame_time_us;
+    link_stats_hist_add(counters.latency_hist, &counters.latency_max_us, us);
+
+    // The frame arrives on core1 and leaves on core0, and the RP2040 has
+    // no cycle counter both cores share, so the 1 us timer is the finest
+    // clock for this interval
+    counters.latency_last_us = us;
+    latency_total_us += us;
+    latency_samples++;
+    counters.latency_avg_us = (uint32_t)(latency_total_us / latency_samples);
+}
+
+void perf_counters_hid_not_ready(void)
+{
+    counters.hid_not_ready++;
+}
+
+void perf_counters_snapshot(link_stats_t *stats)
+{
+    memcpy(stats, (const void *)&counters, sizeof(*stats));
+    stats->uptime_ms = to_ms_since_boot(get_absolute_time());
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "link_stats.h"
+
+// Performance counters kept on core0 (see common/link_stats.h)
+//
+// Always compiled in so a deployed rig can be diagnosed without a debug
+// build. Core0 writes, core1 snapshots them to answer a LINK_TYPE_STATS
+// query; single word reads are atomic, so a snapshot can at worst mix
+// counters a few microseconds apart.
+
+// Once per main loop pass
+void perf_counters_loop(void);
+
+// A HID report was sent
+void perf_counters_report_sent(void);
+
+// The report just sent is the first to carry a new frame; frame_time_us is
+// when core1 took that frame out of the receive ring
+void perf_counters_report_latency(uint32_t frame_time_us);
+
+// A report was due but the IN endpoint was still busy
+void perf_counters_hid_not_ready(void);
+
+// Core0 counters plus uptime; the link fields are left zero for the caller
+void perf_counters_snapshot(link_stats_t *stats);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hardware/sync.h"
+#include "hid_report.h"
+
+// Single-writer, single-reader seqlock carrying the newest decoded report
+// from core1 (link ingest) to core0 (USB). The writer never waits; the
+// reader retries only if it raced a publish, which costs a few cycles.
+//
+// seq is odd while a publish is in progress and advances by two per
+// completed publish, so readers can also tell whether anything new arrived.
+
+// Presses core1 has decoded so far, per button and for the d-pad (leaving
+// neutral), counted mod 256. Lets core0 catch a press that was released
+// again before it read the mailbox (see tap_latch.h).
+#define TAP_INPUTS 17   // 16 buttons, then the d-pad
+#define TAP_DPAD   16
+
+typedef struct {
+    uint8_t presses[TAP_INPUTS];
+    uint8_t hat;             // Direction of the latest d-pad press
+} tap_counts_t;
+
+// Where the report came from
+typedef struct {
+    uint32_t frame_time_us;  // time_us_32() when the frame was received
+    uint8_t link_seq;        // Link sequence number of that frame
+    tap_counts_t taps;
+} report_meta_t;
+
+typedef struct {
+    volatile uint32_t seq;
+    hid_report_t report;
+    report_meta_t meta;
+} report_mailbox_t;
+
+static inline void report_mailbox_publish(report_mailbox_t *mb, const hid_report_t *report,
+                                          const report_meta_t *meta)
+{
+    uint32_t seq = mb->seq;
+
+    mb->seq = seq + 1;
+    __dmb();
+    mb->report = *report;
+    mb->meta = *meta;
+    __dmb();
+    mb->seq = seq + 2;
+}
+
+// Copy the newest report if it differs from *last_seq. Returns false when
+// nothing new has been published since the previous successful read.
+static inline bool report_mailbox_read(report_mailbox_t *mb, hid_report_t *report,
+                                       report_meta_t *meta, uint32_t *last_seq)
+{
+    uint32_t begin, end;
+
+    do {
+        begin = mb->seq;
+        if (begin == *last_seq) {
+            return false;
+        }
+        if (begin & 1) {
+            continue;
+        }
+        __dmb();
+        *report = mb->report;
+        *meta = mb->meta;
+        __dmb();
+        end = mb->seq;
+    } while ((begin & 1) || begin != end);
+
+    *last_seq = begin;
+    return true;
+}
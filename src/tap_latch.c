@@ -0,0 +1,107 @@
+// Tap latching: hold short presses for a minimum number of reports
+
+#include "tap_latch.h"
+
+#define HAT_NEUTRAL 0x08
+
+#include <string.h>
+
+static volatile uint8_t min_hold = TAP_LATCH_DEFAULT_HOLD;
+
+static bool hat_pressed(uint8_t hat)
+{
+    return (hat & 0x0F) < HAT_NEUTRAL;
+}
+
+void tap_counts_update(tap_counts_t *counts, const hid_report_t *before,
+                       const hid_report_t *after)
+{
+    uint16_t pressed = after->buttons & ~before->buttons;
+
+    for (int i = 0; pressed != 0; i++, pressed >>= 1) {
+        if (pressed & 1) {
+            counts->presses[i]++;
+        }
+    }
+
+    // A new direction counts as a press too (rolling over the d-pad)
+    if (hat_pressed(after->hat) && after->hat != before->hat) {
+        counts->presses[TAP_DPAD]++;
+        counts->hat = after->hat;
+    }
+}
+
+void tap_latch_set_min_hold(uint8_t reports)
+{
+    min_hold = reports;
+}
+
+void tap_latch_init(tap_latch_t *latch)
+{
+    memset(latch, 0, sizeof(*latch));
+    latch->held_hat = HAT_NEUTRAL;
+}
+
+static bool start_hold(tap_latch_t *latch, int input)
+{
+    uint8_t reports = min_hold;
+
+    if (latch->hold_left[input] >= reports) {
+        return false;
+    }
+    latch->hold_left[input] = reports;
+    return true;
+}
+
+bool tap_latch_note_counts(tap_latch_t *latch, const tap_counts_t *counts)
+{
+    bool started = false;
+
+    for (int i = 0; i < TAP_INPUTS; i++) {
+        if (counts->presses[i] != latch->presses_seen[i]) {
+            latch->presses_seen[i] = counts->presses[i];
+            started |= start_hold(latch, i);
+            if (i == TAP_DPAD) {
+                latch->held_hat = counts->hat;
+            }
+        }
+    }
+    return started;
+}
+
+bool tap_latch_note_states(tap_latch_t *latch, const hid_report_t *before,
+                           const hid_report_t *after)
+{
+    uint16_t pressed = after->buttons & ~before->buttons;
+    bool started = false;
+
+    for (int i = 0; pressed != 0; i++, pressed >>= 1) {
+        if (pressed & 1) {
+            started |= start_hold(latch, i);
+        }
+    }
+    if (hat_pressed(after->hat) && after->hat != before->hat) {
+        started |= start_hold(latch, TAP_DPAD);
+        latch->held_hat = after->hat;
+    }
+    return started;
+}
+
+void tap_latch_apply(tap_latch_t *latch, hid_report_t *report)
+{
+    for (int i = 0; i < 16; i++) {
+        if (latch->hold_left[i] > 0) {
+            report->buttons |= (uint16_t)(1u << i);
+            latch->hold_left[i]--;
+        }
+    }
+
+    // A held direction only fills in for a neutral d-pad; a direction
+    // pressed now wins
+    if (latch->hold_left[TAP_DPAD] > 0) {
+        if (!hat_pressed(report->hat)) {
+            report->hat = latch->held_hat;
+        }
+        latch->hold_left[TAP_DPAD]--;
+    }
+}
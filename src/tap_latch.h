@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hid_report.h"
+#include "report_mailbox.h"
+
+// Tap latching
+//
+// The console only sees the state a report samples. A button pressed and
+// released between two reports would never reach it, so every press seen
+// in between is held for at least min_hold reports (1 by default, 0 turns
+// latching off). Core1 counts presses per frame into tap_counts_t; core0
+// compares the counts with what it saw last and extends the report.
+
+#define TAP_LATCH_DEFAULT_HOLD 1
+
+// Core0 side, one per virtual controller
+typedef struct {
+    uint8_t presses_seen[TAP_INPUTS];
+    uint8_t hold_left[TAP_INPUTS];
+    uint8_t held_hat;
+} tap_latch_t;
+
+// Core1: count the presses from one decoded frame to the next
+void tap_counts_update(tap_counts_t *counts, const hid_report_t *before,
+                       const hid_report_t *after);
+
+// Either core; applies to every controller and takes effect with the next
+// press
+void tap_latch_set_min_hold(uint8_t reports);
+
+void tap_latch_init(tap_latch_t *latch);
+
+// Core0: note presses published by core1. Returns true if a press started
+// a hold, i.e. the next report has to change.
+bool tap_latch_note_counts(tap_latch_t *latch, const tap_counts_t *counts);
+
+// Core0: note the presses between two states applied directly (timeline)
+bool tap_latch_note_states(tap_latch_t *latch, const hid_report_t *before,
+                           const hid_report_t *after);
+
+// Core0: add held presses to a report about to be sent; call exactly once
+// for every report
+void tap_latch_apply(tap_latch_t *latch, hid_report_t *report);
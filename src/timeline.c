@@ -0,0 +1,84 @@
+// Timeline of timed reports: single-producer, single-consumer ring
+
+#include "timeline.h"
+
+#include "hardware/sync.h"
+
+#define TIMELINE_MASK (TIMELINE_DEPTH - 1)
+
+typedef struct {
+    uint32_t target_us;
+    hid_report_t report;
+} timeline_entry_t;
+
+static timeline_entry_t entries[TIMELINE_DEPTH];
+static volatile uint32_t head = 0;   // Next entry to pop, written by core0
+static volatile uint32_t tail = 0;   // Next free slot, written by core1
+static volatile uint32_t clear_until = 0;  // tail when the last clear came in
+static volatile uint32_t clear_requested = 0;
+static uint32_t clear_seen = 0;
+static timeline_stats_t stats = {0};
+
+bool timeline_push(uint32_t target_us, const hid_report_t *report)
+{
+    uint32_t t = tail;
+
+    if (t - head >= TIMELINE_DEPTH) {
+        stats.overflows++;
+        return false;
+    }
+
+    entries[t & TIMELINE_MASK].target_us = target_us;
+    entries[t & TIMELINE_MASK].report = *report;
+    __dmb();
+    tail = t + 1;
+    stats.queued++;
+    return true;
+}
+
+void timeline_clear(void)
+{
+    // Only what is queued now goes; states pushed after this still play
+    clear_until = tail;
+    __dmb();
+    clear_requested++;
+}
+
+bool timeline_pop_due(uint32_t now_us, hid_report_t *report)
+{
+    uint32_t h = head;
+
+    if (clear_requested != clear_seen) {
+        clear_seen = clear_requested;
+        __dmb();
+        uint32_t until = clear_until;
+        if ((int32_t)(until - h) > 0) {
+            head = h = until;
+        }
+    }
+
+    if (h == tail) {
+        return false;
+    }
+    __dmb();
+
+    const timeline_entry_t *entry = &entries[h & TIMELINE_MASK];
+    int32_t lateness = (int32_t)(now_us - entry->target_us);
+    if (lateness < 0) {
+        return false;
+    }
+    if (lateness > TIMELINE_LATE_US) {
+        stats.late++;
+    }
+    *report = entry->report;
+    stats.applied++;
+
+    __dmb();
+    head = h + 1;
+    return true;
+}
+
+void timeline_get_stats(timeline_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hid_report.h"
+
+// Timeline of timed reports (core1 -> core0)
+//
+// The PC streams states tagged with a target time on this Pico's clock
+// (time_us_32(), see LINK_TYPE_TIME for clock sync). core1 queues them as
+// they arrive and core0 applies each one on the first report at or after
+// its target, so long sequences keep report-exact timing no matter how the
+// frames were spaced on the way here.
+
+#define TIMELINE_DEPTH 256  // Power of two
+
+// Applied this long after its target counts as late
+#define TIMELINE_LATE_US 1000
+
+typedef struct {
+    uint32_t queued;
+    uint32_t applied;
+    uint32_t late;       // Arrived or applied more than TIMELINE_LATE_US late
+    uint32_t overflows;  // Dropped because the queue was full
+} timeline_stats_t;
+
+// Producer (core1). Entries must be pushed in target order; returns false if
+// the queue is full.
+bool timeline_push(uint32_t target_us, const hid_report_t *report);
+
+// Ask the consumer to drop everything queued so far (core1); entries pushed
+// after the call are kept
+void timeline_clear(void);
+
+// Consumer (core0): pop the oldest entry if it is due at now_us. Call until
+// it returns false; every entry is returned so none of its presses are lost.
+bool timeline_pop_due(uint32_t now_us, hid_report_t *report);
+
+void timeline_get_stats(timeline_stats_t *stats);
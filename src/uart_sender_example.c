@@ -6,6 +6,7 @@
 
 #include "pico/stdlib.h"
 #include "hardware/uart.h"
+#include "link_protocol.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -52,8 +53,14 @@ typedef struct __attribute__((packed)) {
     uint8_t  vendor;
 } controller_state_t;
 
+static link_encoder_t link_encoder;
+
 void send_controller_state(controller_state_t *state) {
-    uart_write_blocking(UART_ID, (uint8_t*)state, sizeof(controller_state_t));
+    // Frame the state (sequence number, CRC, COBS) as the Switch Pico expects
+    uint8_t packet[LINK_ENCODED_SIZE(LINK_STATE_SIZE)];
+    size_t len = link_encode(&link_encoder, LINK_TYPE_STATE,
+                             (const uint8_t *)state, sizeof(controller_state_t), packet);
+    uart_write_blocking(UART_ID, packet, len);
 }
 
 void print_help() {
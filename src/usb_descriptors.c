@@ -85,20 +85,34 @@ uint8_t const * tud_hid_descriptor_report_cb(uint8_t itf)
 
 /* ================= Configuration Descriptor ================= */
 
-#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN)
+/* One HID interface per virtual controller, endpoints 0x81 upwards */
+
+#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + S2RC_CONTROLLERS * TUD_HID_DESC_LEN)
+
+#define HID_INTERFACE(n) \
+    TUD_HID_DESCRIPTOR( \
+        (n), \
+        0, \
+        HID_ITF_PROTOCOL_NONE, \
+        sizeof(hid_report_descriptor), \
+        0x81 + (n), /* IN endpoint */ \
+        64, \
+        1 \
+    )
 
 uint8_t const desc_configuration[] = {
-    TUD_CONFIG_DESCRIPTOR(1, 1, 0, CONFIG_TOTAL_LEN, 0x00, 100),
-
-    TUD_HID_DESCRIPTOR(
-        0,
-        0,
-        HID_ITF_PROTOCOL_NONE,
-        sizeof(hid_report_descriptor),
-        0x81,     // IN endpoint
-        64,
-        1
-    )
+    TUD_CONFIG_DESCRIPTOR(1, S2RC_CONTROLLERS, 0, CONFIG_TOTAL_LEN, 0x00, 100),
+
+    HID_INTERFACE(0),
+#if S2RC_CONTROLLERS > 1
+    HID_INTERFACE(1),
+#endif
+#if S2RC_CONTROLLERS > 2
+    HID_INTERFACE(2),
+#endif
+#if S2RC_CONTROLLERS > 3
+    HID_INTERFACE(3),
+#endif
 };
 
 uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
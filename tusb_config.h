@@ -4,8 +4,12 @@
 #define CFG_TUSB_RHPORT0_MODE   (OPT_MODE_DEVICE | OPT_MODE_FULL_SPEED)
 #define CFG_TUD_ENDPOINT0_SIZE  64
 
-// Enable HID only
-#define CFG_TUD_HID             1
+// Enable HID only: one interface per virtual controller (S2RC_CONTROLLERS
+// comes from CMake)
+#ifndef S2RC_CONTROLLERS
+#define S2RC_CONTROLLERS        1
+#endif
+#define CFG_TUD_HID             S2RC_CONTROLLERS
 #define CFG_TUD_CDC             0
 #define CFG_TUD_MSC             0
 #define CFG_TUD_MIDI            0
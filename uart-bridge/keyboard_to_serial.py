@@ -51,6 +51,48 @@ DPAD_LEFT      = 0x06
 DPAD_UP_LEFT   = 0x07
 DPAD_NEUTRAL   = 0x08  # Neutral state (matching GP2040-CE SWITCH_HAT_NOTHING)
 
+# Link framing (matching common/link_protocol.h)
+LINK_PROTOCOL_VERSION = 1
+LINK_TYPE_STATE = 0x01
+
+def crc16_ccitt(data):
+    """CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+def cobs_encode(data):
+    """COBS-encode data so the result contains no zero bytes"""
+    out = bytearray([0])
+    code_index = 0
+    code = 1
+    for byte in data:
+        if byte == 0:
+            out[code_index] = code
+            code_index = len(out)
+            out.append(0)
+            code = 1
+        else:
+            out.append(byte)
+            code += 1
+            if code == 0xFF:
+                out[code_index] = code
+                code_index = len(out)
+                out.append(0)
+                code = 1
+    out[code_index] = code
+    return bytes(out)
+
+def encode_frame(frame_type, seq, payload):
+    """Build a delimited link frame: version, type, seq, payload, CRC16"""
+    body = bytes([LINK_PROTOCOL_VERSION, frame_type, seq & 0xFF]) + payload
+    body += struct.pack('<H', crc16_ccitt(body))
+    return cobs_encode(body) + b'\x00'
+
 # Key mappings (customize these to your preference!)
 KEY_MAPPINGS = {
     # D-Pad: WASD
@@ -182,10 +224,8 @@ class ControllerState:
             return DPAD_NEUTRAL
     
     def to_bytes(self):
-        """Convert state to 10-byte UART protocol packet with headers"""
-        # Header bytes (0xAA 0x55) + 8 data bytes
-        return struct.pack('<BBHBBBBBB', 
-                          0xAA, 0x55,  # Header for packet synchronization
+        """Convert state to the 8-byte STATE frame payload"""
+        return struct.pack('<HBBBBBB', 
                           self.buttons, 
                           self.get_hat(), 
                           self.lx, self.ly, 
@@ -225,6 +265,7 @@ class KeyboardController:
         # Update loop
         self.running = True
         self.last_state = b''
+        self.seq = 0
         
     def get_key_char(self, key):
         """Convert key to character for lookup"""
@@ -348,16 +389,17 @@ class KeyboardController:
     
     def send_state(self, force=False):
         """Send current controller state to serial port"""
-        packet = self.state.to_bytes()
+        payload = self.state.to_bytes()
         
         # Send if state changed or forced
-        if force or packet != self.last_state:
-            self.ser.write(packet)
+        if force or payload != self.last_state:
+            self.ser.write(encode_frame(LINK_TYPE_STATE, self.seq, payload))
             self.ser.flush()  # Ensure immediate transmission
-            self.last_state = packet
+            self.seq = (self.seq + 1) & 0xFF
+            self.last_state = payload
             
             # Show current state (only on actual changes, not forced updates)
-            if packet != self.last_state or force:
+            if payload != self.last_state or force:
                 hat = self.state.get_hat()
                 hat_names = {
                     0x00: 'Up', 0x01: 'Up-Right', 0x02: 'Right', 0x03: 'Down-Right',
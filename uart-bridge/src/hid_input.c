@@ -0,0 +1,709 @@
+// USB HID input: report descriptor parsing and merging (USB host build)
+
+#include "hid_input.h"
+#include "keymap.h"
+#include "tusb.h"
+#include <string.h>
+
+// HID usage pages and usages this bridge understands
+#define PAGE_DESKTOP        0x01
+#define PAGE_KEYBOARD       0x07
+#define PAGE_BUTTON         0x09
+#define USAGE_JOYSTICK      0x04
+#define USAGE_GAMEPAD       0x05
+#define USAGE_KEYBOARD      0x06
+#define USAGE_KEYPAD        0x07
+#define USAGE_MULTI_AXIS    0x08
+#define USAGE_X             0x30   // Followed by Y, Z, Rx, Ry, Rz
+#define USAGE_HAT           0x39
+
+// Report descriptor items (prefix byte with the size bits masked off)
+#define ITEM_INPUT          0x80
+#define ITEM_COLLECTION     0xA0
+#define ITEM_END_COLLECTION 0xC0
+#define ITEM_USAGE_PAGE     0x04
+#define ITEM_LOGICAL_MIN    0x14
+#define ITEM_LOGICAL_MAX    0x24
+#define ITEM_REPORT_SIZE    0x74
+#define ITEM_REPORT_ID      0x84
+#define ITEM_REPORT_COUNT   0x94
+#define ITEM_PUSH           0xA4
+#define ITEM_POP            0xB4
+#define ITEM_USAGE          0x08
+#define ITEM_USAGE_MIN      0x18
+#define ITEM_USAGE_MAX      0x28
+#define ITEM_LONG           0xFE
+
+// Input item flags
+#define INPUT_CONSTANT      0x01
+#define INPUT_VARIABLE      0x02
+#define INPUT_RELATIVE      0x04
+
+#define COLLECTION_APPLICATION 0x01
+
+// Keycodes below HID_KEY_A report errors; ErrorRollOver means too many keys
+#define KEY_ERROR_ROLLOVER  0x01
+
+#define AXIS_X   0
+#define AXIS_Y   1
+#define AXIS_Z   2
+#define AXIS_RX  3
+#define AXIS_RY  4
+#define AXIS_RZ  5
+#define NUM_AXES 6
+
+#define MAX_FIELDS   16
+#define MAX_USAGES   16
+#define MAX_REPORTS  8
+#define MAX_PUSH     2
+
+// Direction flags, for merging D-pads and keyboard sticks
+#define DIR_UP    KEYMAP_UP
+#define DIR_DOWN  KEYMAP_DOWN
+#define DIR_LEFT  KEYMAP_LEFT
+#define DIR_RIGHT KEYMAP_RIGHT
+
+typedef enum {
+    FIELD_KEY_BITMAP,   // One bit per keycode, starting at usage
+    FIELD_KEY_ARRAY,    // count keycodes of bit_size bits
+    FIELD_BUTTONS,      // One bit per button, starting at usage (1-based)
+    FIELD_HAT,
+    FIELD_AXIS,         // usage is the AXIS_* index
+} field_kind_t;
+
+typedef struct {
+    uint8_t kind;
+    uint8_t report_id;     // 0 when the descriptor has no report IDs
+    uint16_t bit_offset;   // From the start of the report, after the ID byte
+    uint8_t bit_size;
+    uint16_t count;
+    uint16_t usage;
+    int32_t logical_min;
+    int32_t logical_max;
+} hid_field_t;
+
+typedef struct {
+    bool used;
+    uint8_t dev_addr;
+    uint8_t instance;
+    bool report_ids;
+    hid_input_kind_t kind;
+
+    hid_field_t fields[MAX_FIELDS];
+    uint8_t num_fields;
+
+    // Latest input
+    uint8_t keys[32];              // Bit per keycode (0xE0-0xE7 are the modifiers)
+    uint32_t buttons;              // Bit per button usage 1-32
+    uint8_t hat;                   // DPAD_*
+    uint8_t axis_mask;             // Axes the descriptor has
+    uint8_t axes[NUM_AXES];        // Scaled to 0-255
+} hid_device_t;
+
+typedef struct {
+    uint16_t usage_page;
+    int32_t logical_min;
+    int32_t logical_max;
+    uint8_t report_size;
+    uint16_t report_count;
+    uint8_t report_id;
+} hid_globals_t;
+
+typedef struct {
+    hid_device_t *dev;
+    hid_globals_t globals;
+    hid_globals_t stack[MAX_PUSH];
+    uint8_t stack_depth;
+
+    // Local items, cleared after every main item. Usages carry their page
+    // in the upper 16 bits.
+    uint32_t usages[MAX_USAGES];
+    uint8_t num_usages;
+    uint32_t usage_min;
+    uint32_t usage_max;
+    bool usage_range;
+
+    uint32_t application;          // Usage of the enclosing application collection
+    uint8_t depth;
+
+    struct {
+        uint8_t id;
+        uint16_t bits;
+    } reports[MAX_REPORTS];
+    uint8_t num_reports;
+} hid_parser_t;
+
+static hid_device_t devices[HID_INPUT_MAX_DEVICES];
+
+// Directions of each HAT value (DPAD_NEUTRAL last)
+static const uint8_t hat_dirs[9] = {
+    DIR_UP, DIR_UP | DIR_RIGHT, DIR_RIGHT, DIR_DOWN | DIR_RIGHT,
+    DIR_DOWN, DIR_DOWN | DIR_LEFT, DIR_LEFT, DIR_UP | DIR_LEFT, 0
+};
+
+//--------------------------------------------------------------------+
+// Report descriptor parsing
+//--------------------------------------------------------------------+
+
+static int32_t item_signed(uint32_t data, uint8_t size)
+{
+    switch (size) {
+        case 1: return (int8_t)data;
+        case 2: return (int16_t)data;
+        default: return (int32_t)data;
+    }
+}
+
+// Bits declared so far in report id; NULL past MAX_REPORTS reports
+static uint16_t *report_bits(hid_parser_t *parser, uint8_t id)
+{
+    for (uint8_t i = 0; i < parser->num_reports; i++) {
+        if (parser->reports[i].id == id) {
+            return &parser->reports[i].bits;
+        }
+    }
+    if (parser->num_reports == MAX_REPORTS) {
+        return NULL;
+    }
+    parser->reports[parser->num_reports].id = id;
+    parser->reports[parser->num_reports].bits = 0;
+    return &parser->reports[parser->num_reports++].bits;
+}
+
+// Usage of element i of the current main item
+static uint32_t local_usage(const hid_parser_t *parser, uint16_t i)
+{
+    if (parser->num_usages > 0) {
+        return parser->usages[i < parser->num_usages ? i : parser->num_usages - 1];
+    }
+    if (parser->usage_range) {
+        uint32_t usage = parser->usage_min + i;
+        return usage <= parser->usage_max ? usage : parser->usage_max;
+    }
+    return 0;
+}
+
+static bool application_supported(uint32_t application)
+{
+    if ((application >> 16) != PAGE_DESKTOP) {
+        return false;
+    }
+    switch (application & 0xFFFF) {
+        case USAGE_JOYSTICK:
+        case USAGE_GAMEPAD:
+        case USAGE_KEYBOARD:
+        case USAGE_KEYPAD:
+        case USAGE_MULTI_AXIS:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Record a field, or grow the previous one when this is its next bit
+// (bitmaps and buttons are declared one bit per element)
+static void add_field(hid_parser_t *parser, uint8_t kind, uint16_t bit_offset, uint16_t usage,
+                      uint16_t count)
+{
+    hid_device_t *dev = parser->dev;
+    const hid_globals_t *g = &parser->globals;
+
+    if (kind == FIELD_KEY_BITMAP || kind == FIELD_BUTTONS) {
+        hid_field_t *last = dev->num_fields ? &dev->fields[dev->num_fields - 1] : NULL;
+        if (last && last->kind == kind && last->report_id == g->report_id &&
+            last->bit_offset + last->count == bit_offset && last->usage + last->count == usage) {
+            last->count += count;
+            return;
+        }
+    }
+    if (dev->num_fields == MAX_FIELDS) {
+        return;
+    }
+
+    hid_field_t *field = &dev->fields[dev->num_fields++];
+    field->kind = kind;
+    field->report_id = g->report_id;
+    field->bit_offset = bit_offset;
+    field->bit_size = g->report_size;
+    field->count = count;
+    field->usage = usage;
+    field->logical_min = g->logical_min;
+    field->logical_max = g->logical_max;
+}
+
+static void parse_input(hid_parser_t *parser, uint32_t flags)
+{
+    const hid_globals_t *g = &parser->globals;
+    uint16_t *bits = report_bits(parser, g->report_id);
+    if (!bits) {
+        return;
+    }
+    uint16_t offset = *bits;
+
+    *bits += g->report_size * g->report_count;
+    if ((flags & INPUT_CONSTANT) || g->report_size == 0 ||
+        !application_supported(parser->application)) {
+        return;
+    }
+
+    if (!(flags & INPUT_VARIABLE)) {
+        // Array: only keycode arrays are used (boot-style keyboards)
+        uint32_t usage = local_usage(parser, 0);
+        if ((usage >> 16) == PAGE_KEYBOARD && g->report_size <= 8) {
+            add_field(parser, FIELD_KEY_ARRAY, offset, usage & 0xFFFF, g->report_count);
+        }
+        return;
+    }
+
+    for (uint16_t i = 0; i < g->report_count; i++) {
+        uint32_t usage = local_usage(parser, i);
+        uint16_t page = usage >> 16;
+        uint16_t id = usage & 0xFFFF;
+        uint16_t bit_offset = offset + i * g->report_size;
+
+        if (page == PAGE_KEYBOARD && g->report_size == 1 && id < 256) {
+            add_field(parser, FIELD_KEY_BITMAP, bit_offset, id, 1);
+        } else if (page == PAGE_BUTTON && g->report_size == 1 && id >= 1 && id <= 32) {
+            add_field(parser, FIELD_BUTTONS, bit_offset, id, 1);
+        } else if (page == PAGE_DESKTOP && id == USAGE_HAT && g->report_size <= 8) {
+            add_field(parser, FIELD_HAT, bit_offset, id, 1);
+        } else if (page == PAGE_DESKTOP && id >= USAGE_X && id < USAGE_X + NUM_AXES &&
+                   g->report_size <= 16 && !(flags & INPUT_RELATIVE)) {
+            add_field(parser, FIELD_AXIS, bit_offset, id - USAGE_X, 1);
+            parser->dev->axis_mask |= (uint8_t)(1u << (id - USAGE_X));
+        }
+    }
+}
+
+static void parse_descriptor(hid_device_t *dev, const uint8_t *desc, uint16_t len)
+{
+    hid_parser_t parser;
+    memset(&parser, 0, sizeof(parser));
+    parser.dev = dev;
+
+    uint16_t pos = 0;
+    while (pos < len) {
+        uint8_t prefix = desc[pos];
+        if (prefix == ITEM_LONG) {
+            // Long items aren't used by any input device; skip the data
+            pos += (pos + 1 < len) ? 3 + desc[pos + 1] : 1;
+            continue;
+        }
+
+        uint8_t size = prefix & 0x03;
+        if (size == 3) size = 4;
+        if (pos + 1 + size > len) {
+            break;
+        }
+        uint32_t data = 0;
+        for (uint8_t i = 0; i < size; i++) {
+            data |= (uint32_t)desc[pos + 1 + i] << (8 * i);
+        }
+        pos += 1 + size;
+
+        hid_globals_t *g = &parser.globals;
+        uint32_t usage = size == 4 ? data : ((uint32_t)g->usage_page << 16) | data;
+
+        switch (prefix & 0xFC) {
+            case ITEM_USAGE_PAGE:   g->usage_page = (uint16_t)data; break;
+            case ITEM_LOGICAL_MIN:  g->logical_min = item_signed(data, size); break;
+            case ITEM_LOGICAL_MAX:
+                g->logical_max = item_signed(data, size);
+                // Descriptors often write 255 as the single byte 0xFF
+                if (g->logical_min >= 0 && g->logical_max < g->logical_min) {
+                    g->logical_max = (int32_t)data;
+                }
+                break;
+            case ITEM_REPORT_SIZE:  g->report_size = (uint8_t)data; break;
+            case ITEM_REPORT_COUNT: g->report_count = (uint16_t)data; break;
+            case ITEM_REPORT_ID:
+                g->report_id = (uint8_t)data;
+                dev->report_ids = true;
+                break;
+            case ITEM_PUSH:
+                if (parser.stack_depth < MAX_PUSH) {
+                    parser.stack[parser.stack_depth++] = *g;
+                }
+                break;
+            case ITEM_POP:
+                if (parser.stack_depth > 0) {
+                    *g = parser.stack[--parser.stack_depth];
+                }
+                break;
+
+            case ITEM_USAGE:
+                if (parser.num_usages < MAX_USAGES) {
+                    parser.usages[parser.num_usages++] = usage;
+                }
+                break;
+            case ITEM_USAGE_MIN:
+                parser.usage_min = usage;
+                parser.usage_range = true;
+                break;
+            case ITEM_USAGE_MAX:
+                parser.usage_max = usage;
+                parser.usage_range = true;
+                break;
+
+            case ITEM_COLLECTION:
+                if (data == COLLECTION_APPLICATION && parser.depth == 0) {
+                    parser.application = local_usage(&parser, 0);
+                }
+                parser.depth++;
+                break;
+            case ITEM_END_COLLECTION:
+                if (parser.depth > 0 && --parser.depth == 0) {
+                    parser.application = 0;
+                }
+                break;
+            case ITEM_INPUT:
+                parse_input(&parser, data);
+                break;
+
+            default:
+                break;
+        }
+
+        // Main items consume the local items
+        if ((prefix & 0x0C) == 0x00) {
+            parser.num_usages = 0;
+            parser.usage_range = false;
+        }
+    }
+}
+
+//--------------------------------------------------------------------+
+// Reports
+//--------------------------------------------------------------------+
+
+static uint32_t read_bits(const uint8_t *data, uint16_t len, uint16_t offset, uint8_t size)
+{
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < size; i++) {
+        uint16_t bit = offset + i;
+        if ((bit >> 3) >= len) {
+            break;
+        }
+        if (data[bit >> 3] & (1u << (bit & 7))) {
+            value |= 1u << i;
+        }
+    }
+    return value;
+}
+
+static int32_t read_value(const hid_field_t *field, const uint8_t *data, uint16_t len,
+                          uint16_t index)
+{
+    uint32_t raw = read_bits(data, len, field->bit_offset + index * field->bit_size,
+                             field->bit_size);
+    if (field->logical_min < 0 && field->bit_size < 32 && (raw & (1u << (field->bit_size - 1)))) {
+        return (int32_t)(raw | ~((1u << field->bit_size) - 1));
+    }
+    return (int32_t)raw;
+}
+
+static uint8_t scale_axis(const hid_field_t *field, int32_t value)
+{
+    int32_t range = field->logical_max - field->logical_min;
+    if (range <= 0) {
+        return 128;
+    }
+    if (value < field->logical_min) value = field->logical_min;
+    if (value > field->logical_max) value = field->logical_max;
+    return (uint8_t)(((int64_t)(value - field->logical_min) * 255 + range / 2) / range);
+}
+
+// 8-way hats count clockwise from up like DPAD_*; 4-way hats skip the diagonals.
+// Values outside the logical range mean centered.
+static uint8_t read_hat(const hid_field_t *field, int32_t value)
+{
+    int32_t range = field->logical_max - field->logical_min;
+    if (value < field->logical_min || value > field->logical_max) {
+        return DPAD_NEUTRAL;
+    }
+    int32_t position = value - field->logical_min;
+    if (range == 7) return (uint8_t)position;
+    if (range == 3) return (uint8_t)(position * 2);
+    return DPAD_NEUTRAL;
+}
+
+static void set_key(hid_device_t *dev, uint16_t keycode)
+{
+    if (keycode < 256) {
+        dev->keys[keycode >> 3] |= (uint8_t)(1u << (keycode & 7));
+    }
+}
+
+static void apply_report(hid_device_t *dev, uint8_t report_id, const uint8_t *data, uint16_t len)
+{
+    // A keyboard reports ErrorRollOver in every slot when too many keys are
+    // down to tell which; keep the previous keys until it can again
+    bool keys_valid = true;
+    bool has_keys = false;
+    for (uint8_t f = 0; f < dev->num_fields; f++) {
+        const hid_field_t *field = &dev->fields[f];
+        if (field->report_id != report_id ||
+            (field->kind != FIELD_KEY_BITMAP && field->kind != FIELD_KEY_ARRAY)) {
+            continue;
+        }
+        has_keys = true;
+        if (field->kind == FIELD_KEY_ARRAY) {
+            for (uint16_t i = 0; i < field->count; i++) {
+                int32_t value = read_value(field, data, len, i);
+                if (field->usage + value - field->logical_min == KEY_ERROR_ROLLOVER) {
+                    keys_valid = false;
+                }
+            }
+        }
+    }
+    if (has_keys && keys_valid) {
+        memset(dev->keys, 0, sizeof(dev->keys));
+    }
+
+    for (uint8_t f = 0; f < dev->num_fields; f++) {
+        const hid_field_t *field = &dev->fields[f];
+        if (field->report_id != report_id) {
+            continue;
+        }
+
+        switch (field->kind) {
+            case FIELD_KEY_BITMAP:
+                if (keys_valid) {
+                    for (uint16_t i = 0; i < field->count; i++) {
+                        if (read_bits(data, len, field->bit_offset + i, 1)) {
+                            set_key(dev, field->usage + i);
+                        }
+                    }
+                }
+                break;
+
+            case FIELD_KEY_ARRAY:
+                if (keys_valid) {
+                    for (uint16_t i = 0; i < field->count; i++) {
+                        int32_t value = read_value(field, data, len, i);
+                        if (value >= field->logical_min && value <= field->logical_max) {
+                            uint32_t keycode = field->usage + value - field->logical_min;
+                            if (keycode >= HID_KEY_A) {
+                                set_key(dev, (uint16_t)keycode);
+                            }
+                        }
+                    }
+                }
+                break;
+
+            case FIELD_BUTTONS:
+                for (uint16_t i = 0; i < field->count; i++) {
+                    uint32_t bit = 1u << (field->usage + i - 1);
+                    if (read_bits(data, len, field->bit_offset + i, 1)) {
+                        dev->buttons |= bit;
+                    } else {
+                        dev->buttons &= ~bit;
+                    }
+                }
+                break;
+
+            case FIELD_HAT:
+                dev->hat = read_hat(field, read_value(field, data, len, 0));
+                break;
+
+            case FIELD_AXIS:
+                dev->axes[field->usage] = scale_axis(field, read_value(field, data, len, 0));
+                break;
+        }
+    }
+}
+
+//--------------------------------------------------------------------+
+// Device table
+//--------------------------------------------------------------------+
+
+static hid_device_t *find_device(uint8_t dev_addr, uint8_t instance)
+{
+    for (int i = 0; i < HID_INPUT_MAX_DEVICES; i++) {
+        if (devices[i].used && devices[i].dev_addr == dev_addr &&
+            devices[i].instance == instance) {
+            return &devices[i];
+        }
+    }
+    return NULL;
+}
+
+void hid_input_init(void)
+{
+    memset(devices, 0, sizeof(devices));
+}
+
+hid_input_kind_t hid_input_mount(uint8_t dev_addr, uint8_t instance,
+                                 const uint8_t *desc_report, uint16_t desc_len)
+{
+    hid_device_t *dev = NULL;
+    for (int i = 0; i < HID_INPUT_MAX_DEVICES && !dev; i++) {
+        if (!devices[i].used) {
+            dev = &devices[i];
+        }
+    }
+    if (!dev) {
+        return HID_INPUT_UNKNOWN;
+    }
+
+    memset(dev, 0, sizeof(*dev));
+    parse_descriptor(dev, desc_report, desc_len);
+
+    dev->kind = HID_INPUT_UNKNOWN;
+    for (uint8_t f = 0; f < dev->num_fields; f++) {
+        uint8_t kind = dev->fields[f].kind;
+        if (kind == FIELD_KEY_BITMAP || kind == FIELD_KEY_ARRAY) {
+            dev->kind = HID_INPUT_KEYBOARD;
+            break;
+        }
+        dev->kind = HID_INPUT_GAMEPAD;
+    }
+    if (dev->kind == HID_INPUT_UNKNOWN) {
+        return HID_INPUT_UNKNOWN;
+    }
+
+    dev->used = true;
+    dev->dev_addr = dev_addr;
+    dev->instance = instance;
+    dev->hat = DPAD_NEUTRAL;
+    memset(dev->axes, 128, sizeof(dev->axes));
+    return dev->kind;
+}
+
+void hid_input_unmount(uint8_t dev_addr, uint8_t instance)
+{
+    hid_device_t *dev = find_device(dev_addr, instance);
+    if (dev) {
+        dev->used = false;
+    }
+}
+
+bool hid_input_report(uint8_t dev_addr, uint8_t instance, const uint8_t *report, uint16_t len)
+{
+    hid_device_t *dev = find_device(dev_addr, instance);
+    if (!dev) {
+        return false;
+    }
+
+    uint8_t report_id = 0;
+    if (dev->report_ids) {
+        if (len == 0) {
+            return true;
+        }
+        report_id = report[0];
+        report++;
+        len--;
+    }
+    apply_report(dev, report_id, report, len);
+    return true;
+}
+
+int hid_input_count(void)
+{
+    int count = 0;
+    for (int i = 0; i < HID_INPUT_MAX_DEVICES; i++) {
+        if (devices[i].used) {
+            count++;
+        }
+    }
+    return count;
+}
+
+//--------------------------------------------------------------------+
+// Merging
+//--------------------------------------------------------------------+
+
+// Keep whichever value is further from center
+static void take_further(uint8_t *axis, uint8_t value)
+{
+    int current = *axis - 128;
+    int candidate = value - 128;
+    if (candidate * candidate > current * current) {
+        *axis = value;
+    }
+}
+
+static uint8_t stick_x(uint8_t dirs)
+{
+    return (dirs & DIR_LEFT) ? 0 : (dirs & DIR_RIGHT) ? 255 : 128;
+}
+
+static uint8_t stick_y(uint8_t dirs)
+{
+    // Y-axis inverted: 0 = up
+    return (dirs & DIR_UP) ? 0 : (dirs & DIR_DOWN) ? 255 : 128;
+}
+
+static uint8_t hat_from_dirs(uint8_t dirs)
+{
+    bool up = dirs & DIR_UP, down = dirs & DIR_DOWN;
+    bool left = dirs & DIR_LEFT, right = dirs & DIR_RIGHT;
+
+    if (up && right) return DPAD_UP_RIGHT;
+    if (up && left) return DPAD_UP_LEFT;
+    if (down && right) return DPAD_DN_RIGHT;
+    if (down && left) return DPAD_DN_LEFT;
+    if (up) return DPAD_UP;
+    if (down) return DPAD_DOWN;
+    if (left) return DPAD_LEFT;
+    if (right) return DPAD_RIGHT;
+    return DPAD_NEUTRAL;
+}
+
+static void merge_keyboard(const hid_device_t *dev, controller_state_t *state, uint8_t *dpad,
+                           uint8_t *lstick, uint8_t *rstick)
+{
+    // One table lookup per pressed key
+    for (int byte = 0; byte < (int)sizeof(dev->keys); byte++) {
+        uint8_t bits = dev->keys[byte];
+        while (bits) {
+            int bit = __builtin_ctz(bits);
+            bits &= (uint8_t)(bits - 1);
+
+            const keymap_entry_t *entry = keymap_lookup((uint8_t)(byte * 8 + bit));
+            state->buttons |= entry->buttons;
+            *dpad |= entry->dpad;
+            *lstick |= entry->lstick;
+            *rstick |= entry->rstick;
+        }
+    }
+}
+
+// HID buttons 1-16 map onto the Switch button bits in order (B, A, Y, X, ...),
+// which is the layout Switch-compatible pads report. Sticks are X/Y, and Z/Rz
+// (DirectInput pads) or else Rx/Ry (XInput-style pads).
+static void merge_gamepad(const hid_device_t *dev, controller_state_t *state, uint8_t *dpad)
+{
+    state->buttons |= (uint16_t)dev->buttons;
+    *dpad |= hat_dirs[dev->hat];
+
+    bool z_rz = dev->axis_mask & ((1u << AXIS_Z) | (1u << AXIS_RZ));
+    take_further(&state->lx, dev->axes[AXIS_X]);
+    take_further(&state->ly, dev->axes[AXIS_Y]);
+    take_further(&state->rx, dev->axes[z_rz ? AXIS_Z : AXIS_RX]);
+    take_further(&state->ry, dev->axes[z_rz ? AXIS_RZ : AXIS_RY]);
+}
+
+void hid_input_get_state(controller_state_t *state)
+{
+    uint8_t dpad = 0, lstick = 0, rstick = 0;
+
+    memset(state, 0, sizeof(*state));
+    state->lx = state->ly = state->rx = state->ry = 128;
+
+    for (int i = 0; i < HID_INPUT_MAX_DEVICES; i++) {
+        const hid_device_t *dev = &devices[i];
+        if (!dev->used) {
+            continue;
+        }
+        // One interface may be both (keyboards with a gamepad report)
+        merge_keyboard(dev, state, &dpad, &lstick, &rstick);
+        merge_gamepad(dev, state, &dpad);
+    }
+
+    state->hat = hat_from_dirs(dpad);
+    take_further(&state->lx, stick_x(lstick));
+    take_further(&state->ly, stick_y(lstick));
+    take_further(&state->rx, stick_x(rstick));
+    take_further(&state->ry, stick_y(rstick));
+}
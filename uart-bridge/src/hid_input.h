@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// USB HID input on the bridge (USB host build, main.c)
+//
+// Keeps a table of every HID interface TinyUSB mounts, through a hub if one
+// is attached. Each interface's report descriptor is parsed at mount time to
+// find the fields this bridge understands:
+//   - keyboards: the boot-style keycode array, and the key bitmap that
+//     report-protocol (NKRO) keyboards use, including modifiers
+//   - gamepads: buttons, hat switch and the X/Y/Z/Rx/Ry/Rz axes
+// hid_input_get_state() merges all of them into one controller state, with
+// keys translated through the keymap (keymap.h).
+
+// Button definitions matching the Switch Pico
+// Standard Nintendo Switch HID button order: B, A, Y, X, L, R, ZL, ZR, -, +, LS, RS, Home, Capture
+#define BTN_B       (1 << 0)
+#define BTN_A       (1 << 1)
+#define BTN_Y       (1 << 2)
+#define BTN_X       (1 << 3)
+#define BTN_L       (1 << 4)
+#define BTN_R       (1 << 5)
+#define BTN_ZL      (1 << 6)
+#define BTN_ZR      (1 << 7)
+#define BTN_MINUS   (1 << 8)
+#define BTN_PLUS    (1 << 9)
+#define BTN_LSTICK  (1 << 10)
+#define BTN_RSTICK  (1 << 11)
+#define BTN_HOME    (1 << 12)
+#define BTN_CAPTURE (1 << 13)
+#define BTN_GL      (1 << 14)  // Grip Left / Back Left
+#define BTN_GR      (1 << 15)  // Grip Right / Back Right
+
+// D-Pad definitions (HAT values)
+#define DPAD_UP        0x00
+#define DPAD_UP_RIGHT  0x01
+#define DPAD_RIGHT     0x02
+#define DPAD_DN_RIGHT  0x03
+#define DPAD_DOWN      0x04
+#define DPAD_DN_LEFT   0x05
+#define DPAD_LEFT      0x06
+#define DPAD_UP_LEFT   0x07
+#define DPAD_NEUTRAL   0x08
+
+typedef struct __attribute__((packed)) {
+    uint16_t buttons;
+    uint8_t  hat;
+    uint8_t  lx;
+    uint8_t  ly;
+    uint8_t  rx;
+    uint8_t  ry;
+    uint8_t  vendor;
+} controller_state_t;
+
+// Interfaces tracked at once (matches CFG_TUH_HID)
+#define HID_INPUT_MAX_DEVICES 8
+
+typedef enum {
+    HID_INPUT_UNKNOWN = 0,   // Nothing usable in the descriptor
+    HID_INPUT_KEYBOARD,
+    HID_INPUT_GAMEPAD,
+} hid_input_kind_t;
+
+void hid_input_init(void);
+
+// Parse the interface's report descriptor and start tracking it. Returns
+// what was found; HID_INPUT_UNKNOWN (or a full table) means it is ignored.
+hid_input_kind_t hid_input_mount(uint8_t dev_addr, uint8_t instance,
+                                 const uint8_t *desc_report, uint16_t desc_len);
+
+void hid_input_unmount(uint8_t dev_addr, uint8_t instance);
+
+// Apply one input report; false if the interface isn't tracked
+bool hid_input_report(uint8_t dev_addr, uint8_t instance, const uint8_t *report, uint16_t len);
+
+// Number of interfaces being tracked
+int hid_input_count(void);
+
+// All devices merged: buttons and D-pad directions are OR'ed, and each stick
+// axis takes whichever device pushes it furthest from center
+void hid_input_get_state(controller_state_t *state);
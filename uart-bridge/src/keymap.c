@@ -0,0 +1,307 @@
+// Keyboard mapping: keycode-indexed table, binding parser, flash storage
+
+#include "keymap.h"
+#include "hid_input.h"
+#include "link_protocol.h"
+#include "tusb.h"
+
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#define KEYMAP_MAGIC 0x50414D4Bu   // "KMAP"
+
+// The bridge has no other use for flash; take the last sector like the
+// Switch Pico's macro store
+#define KEYMAP_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+#define FLASH_ENTER_EXIT_TIMEOUT_MS 100
+
+#define MAX_LINE 64
+
+typedef struct {
+    uint32_t magic;
+    uint16_t crc;          // link_crc16 of the entries
+    uint16_t reserved;
+    keymap_entry_t entries[KEYMAP_KEYS];
+} keymap_image_t;
+
+// Flash is programmed in whole pages
+#define KEYMAP_PROGRAM_SIZE \
+    ((sizeof(keymap_image_t) + FLASH_PAGE_SIZE - 1) & ~(FLASH_PAGE_SIZE - 1))
+
+static keymap_entry_t keymap[KEYMAP_KEYS];
+static uint8_t program_buffer[KEYMAP_PROGRAM_SIZE];
+
+// Same layout the bridge always had
+static const char *const default_bindings[] = {
+    // D-Pad: WASD and arrow keys
+    "w = dpad:up", "s = dpad:down", "a = dpad:left", "d = dpad:right",
+    "up = dpad:up", "down = dpad:down", "left = dpad:left", "right = dpad:right",
+
+    // Face buttons: IJKL
+    "i = button:X", "k = button:B", "j = button:Y", "l = button:A",
+
+    // Shoulders: Q E R F (and G T as alternatives)
+    "q = button:L", "e = button:R", "r = button:ZL", "f = button:ZR",
+    "g = button:L", "t = button:R",
+
+    // System buttons
+    "1 = button:MINUS", "2 = button:PLUS", "3 = button:LSTICK", "4 = button:RSTICK",
+    "h = button:HOME", "c = button:CAPTURE",
+
+    // Left Analog Stick: Numpad 8456
+    "num8 = lstick:up", "num5 = lstick:down", "num4 = lstick:left", "num6 = lstick:right",
+
+    // Right Analog Stick: U M N ,
+    "u = rstick:up", "m = rstick:down", "n = rstick:left", "comma = rstick:right",
+};
+
+// Key names as in controller_bridge's INI, plus a few it lacks. Letters,
+// digits, f1-f12 and num0-num9 are handled in key_from_name.
+typedef struct {
+    const char *name;
+    uint8_t keycode;
+} key_name_t;
+
+static const key_name_t key_names[] = {
+    {"space", HID_KEY_SPACE}, {"enter", HID_KEY_ENTER}, {"escape", HID_KEY_ESCAPE},
+    {"tab", HID_KEY_TAB}, {"backspace", HID_KEY_BACKSPACE}, {"delete", HID_KEY_DELETE},
+    {"up", HID_KEY_ARROW_UP}, {"down", HID_KEY_ARROW_DOWN},
+    {"left", HID_KEY_ARROW_LEFT}, {"right", HID_KEY_ARROW_RIGHT},
+    {"shift", HID_KEY_SHIFT_LEFT}, {"ctrl", HID_KEY_CONTROL_LEFT}, {"alt", HID_KEY_ALT_LEFT},
+    {"rshift", HID_KEY_SHIFT_RIGHT}, {"rctrl", HID_KEY_CONTROL_RIGHT}, {"ralt", HID_KEY_ALT_RIGHT},
+    {"comma", HID_KEY_COMMA},
+};
+
+#define NUM_KEY_NAMES (sizeof(key_names) / sizeof(key_names[0]))
+
+typedef struct {
+    const char *name;
+    uint16_t button;
+} button_name_t;
+
+static const button_name_t button_names[] = {
+    {"B", BTN_B}, {"A", BTN_A}, {"Y", BTN_Y}, {"X", BTN_X},
+    {"L", BTN_L}, {"R", BTN_R}, {"ZL", BTN_ZL}, {"ZR", BTN_ZR},
+    {"MINUS", BTN_MINUS}, {"PLUS", BTN_PLUS}, {"LSTICK", BTN_LSTICK}, {"RSTICK", BTN_RSTICK},
+    {"HOME", BTN_HOME}, {"CAPTURE", BTN_CAPTURE}, {"GL", BTN_GL}, {"GR", BTN_GR},
+};
+
+static const char *const direction_names[4] = { "up", "down", "left", "right" };
+
+// HID keycode for a name, or -1. Keycodes may also be given as 0x04-0xFF.
+static int key_from_name(const char *name)
+{
+    size_t len = strlen(name);
+
+    if (len == 1 && isalpha((unsigned char)name[0])) {
+        return HID_KEY_A + (tolower((unsigned char)name[0]) - 'a');
+    }
+    if (len == 1 && isdigit((unsigned char)name[0])) {
+        return name[0] == '0' ? HID_KEY_0 : HID_KEY_1 + (name[0] - '1');
+    }
+    if (strncasecmp(name, "0x", 2) == 0) {
+        char *end;
+        long keycode = strtol(name, &end, 16);
+        return (*end == '\0' && keycode >= HID_KEY_A && keycode < KEYMAP_KEYS) ? (int)keycode : -1;
+    }
+    if ((name[0] == 'f' || name[0] == 'F') && isdigit((unsigned char)name[1])) {
+        int n = atoi(name + 1);
+        return (n >= 1 && n <= 12) ? HID_KEY_F1 + n - 1 : -1;
+    }
+    if (strncasecmp(name, "num", 3) == 0 && isdigit((unsigned char)name[3]) && name[4] == '\0') {
+        return name[3] == '0' ? HID_KEY_KEYPAD_0 : HID_KEY_KEYPAD_1 + (name[3] - '1');
+    }
+    for (size_t i = 0; i < NUM_KEY_NAMES; i++) {
+        if (strcasecmp(key_names[i].name, name) == 0) {
+            return key_names[i].keycode;
+        }
+    }
+    return -1;
+}
+
+// Inverse of key_from_name, for printing
+static void key_to_name(uint8_t keycode, char *name, size_t size)
+{
+    if (keycode >= HID_KEY_A && keycode <= HID_KEY_Z) {
+        snprintf(name, size, "%c", 'a' + (keycode - HID_KEY_A));
+    } else if (keycode >= HID_KEY_1 && keycode <= HID_KEY_0) {
+        snprintf(name, size, "%c", keycode == HID_KEY_0 ? '0' : '1' + (keycode - HID_KEY_1));
+    } else if (keycode >= HID_KEY_F1 && keycode <= HID_KEY_F12) {
+        snprintf(name, size, "f%d", keycode - HID_KEY_F1 + 1);
+    } else if (keycode >= HID_KEY_KEYPAD_1 && keycode <= HID_KEY_KEYPAD_0) {
+        snprintf(name, size, "num%c",
+                 keycode == HID_KEY_KEYPAD_0 ? '0' : '1' + (keycode - HID_KEY_KEYPAD_1));
+    } else {
+        snprintf(name, size, "0x%02X", keycode);
+        for (size_t i = 0; i < NUM_KEY_NAMES; i++) {
+            if (key_names[i].keycode == keycode) {
+                snprintf(name, size, "%s", key_names[i].name);
+                break;
+            }
+        }
+    }
+}
+
+static uint8_t direction_from_name(const char *name)
+{
+    for (int i = 0; i < 4; i++) {
+        if (strcasecmp(direction_names[i], name) == 0) {
+            return (uint8_t)(1u << i);
+        }
+    }
+    return 0;
+}
+
+static char *trim(char *str)
+{
+    while (isspace((unsigned char)*str)) str++;
+    char *end = str + strlen(str);
+    while (end > str && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return str;
+}
+
+const keymap_entry_t *keymap_lookup(uint8_t keycode)
+{
+    return &keymap[keycode];
+}
+
+bool keymap_bind(const char *line)
+{
+    char buffer[MAX_LINE];
+    if (strlen(line) >= sizeof(buffer)) {
+        return false;
+    }
+    strcpy(buffer, line);
+
+    char *text = trim(buffer);
+    if (*text == '\0' || *text == '#' || *text == ';' || *text == '[') {
+        return true;
+    }
+
+    char *equals = strchr(text, '=');
+    char *colon = equals ? strchr(equals, ':') : NULL;
+    if (!colon) {
+        return false;
+    }
+    *equals = '\0';
+    *colon = '\0';
+    char *key = trim(text);
+    char *type = trim(equals + 1);
+    char *value = trim(colon + 1);
+
+    int keycode = key_from_name(key);
+    if (keycode < 0) {
+        return false;
+    }
+    keymap_entry_t *entry = &keymap[keycode];
+
+    if (strcasecmp(type, "button") == 0) {
+        for (size_t i = 0; i < sizeof(button_names) / sizeof(button_names[0]); i++) {
+            if (strcasecmp(button_names[i].name, value) == 0) {
+                entry->buttons |= button_names[i].button;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint8_t direction = direction_from_name(value);
+    if (direction == 0) {
+        return false;
+    }
+    if (strcasecmp(type, "dpad") == 0) {
+        entry->dpad |= direction;
+    } else if (strcasecmp(type, "lstick") == 0) {
+        entry->lstick |= direction;
+    } else if (strcasecmp(type, "rstick") == 0) {
+        entry->rstick |= direction;
+    } else {
+        return false;  // Including macro:, which needs the PC
+    }
+    return true;
+}
+
+void keymap_clear(void)
+{
+    memset(keymap, 0, sizeof(keymap));
+}
+
+void keymap_load_defaults(void)
+{
+    keymap_clear();
+    for (size_t i = 0; i < sizeof(default_bindings) / sizeof(default_bindings[0]); i++) {
+        keymap_bind(default_bindings[i]);
+    }
+}
+
+static const keymap_image_t *stored_image(void)
+{
+    return (const keymap_image_t *)(XIP_BASE + KEYMAP_FLASH_OFFSET);
+}
+
+void keymap_init(void)
+{
+    const keymap_image_t *image = stored_image();
+    if (image->magic == KEYMAP_MAGIC &&
+        link_crc16((const uint8_t *)image->entries, sizeof(image->entries)) == image->crc) {
+        memcpy(keymap, image->entries, sizeof(keymap));
+    } else {
+        keymap_load_defaults();
+    }
+}
+
+// Runs with interrupts off
+static void program_sector(void *param)
+{
+    (void)param;
+    flash_range_erase(KEYMAP_FLASH_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(KEYMAP_FLASH_OFFSET, program_buffer, sizeof(program_buffer));
+}
+
+bool keymap_save(void)
+{
+    keymap_image_t *image = (keymap_image_t *)program_buffer;
+
+    memset(program_buffer, 0xFF, sizeof(program_buffer));
+    image->magic = KEYMAP_MAGIC;
+    image->reserved = 0;
+    memcpy(image->entries, keymap, sizeof(keymap));
+    image->crc = link_crc16((const uint8_t *)image->entries, sizeof(image->entries));
+
+    return flash_safe_execute(program_sector, NULL, FLASH_ENTER_EXIT_TIMEOUT_MS) == PICO_OK &&
+           memcmp(stored_image(), program_buffer, sizeof(keymap_image_t)) == 0;
+}
+
+static void print_directions(const char *key, const char *type, uint8_t directions)
+{
+    for (int i = 0; i < 4; i++) {
+        if (directions & (1u << i)) {
+            printf("%s = %s:%s\n", key, type, direction_names[i]);
+        }
+    }
+}
+
+void keymap_print(void)
+{
+    for (int keycode = 0; keycode < KEYMAP_KEYS; keycode++) {
+        const keymap_entry_t *entry = &keymap[keycode];
+        char key[16];
+
+        key_to_name((uint8_t)keycode, key, sizeof(key));
+        for (size_t i = 0; i < sizeof(button_names) / sizeof(button_names[0]); i++) {
+            if (entry->buttons & button_names[i].button) {
+                printf("%s = button:%s\n", key, button_names[i].name);
+            }
+        }
+        print_directions(key, "dpad", entry->dpad);
+        print_directions(key, "lstick", entry->lstick);
+        print_directions(key, "rstick", entry->rstick);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Keyboard mapping for the USB host build
+//
+// One entry per HID keycode, so a pressed key is looked up directly. Each
+// entry ORs buttons, D-pad and stick directions into the controller state;
+// a key may drive several of them, as in controller_bridge (whose default
+// config binds 's' to both ZR and the left stick).
+//
+// Bindings use the [KeyBindings] syntax of controller_bridge's INI file,
+// "key = type:value", and can be typed or pasted on the debug console. The
+// table is kept in RAM and saved to the last flash sector on request; at
+// boot the saved table is loaded, or the built-in layout if none is stored.
+
+#define KEYMAP_KEYS 256
+
+// Direction flags for dpad, lstick and rstick
+#define KEYMAP_UP    (1 << 0)
+#define KEYMAP_DOWN  (1 << 1)
+#define KEYMAP_LEFT  (1 << 2)
+#define KEYMAP_RIGHT (1 << 3)
+
+typedef struct __attribute__((packed)) {
+    uint16_t buttons;
+    uint8_t dpad;
+    uint8_t lstick;
+    uint8_t rstick;
+    uint8_t reserved;
+} keymap_entry_t;
+
+// Load the table saved in flash, or the built-in layout
+void keymap_init(void);
+
+const keymap_entry_t *keymap_lookup(uint8_t keycode);
+
+// Add one binding, e.g. "w = dpad:up" or "k = button:A". Blank lines,
+// '#' comments and "[Section]" headers are accepted and ignored, so a whole
+// [KeyBindings] section can be pasted. Returns false if malformed.
+bool keymap_bind(const char *line);
+
+// Remove every binding
+void keymap_clear(void);
+
+// Replace the table with the built-in layout
+void keymap_load_defaults(void);
+
+// Write the table to flash; false if the write didn't verify
+bool keymap_save(void);
+
+// Print the table in binding syntax (stdio)
+void keymap_print(void);
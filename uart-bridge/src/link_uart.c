@@ -0,0 +1,179 @@
+// UART link to the Switch Pico with DMA transmit and runtime baud negotiation
+//
+// Replies land in the DMA ring from common/link_rx_ring.c, as on the Switch
+// Pico: stats replies and forwarded output reports are far longer than the
+// 32-byte FIFO holds at 3 Mbaud between two main-loop passes.
+
+#include "link_uart.h"
+#include "link_baud.h"
+#include "link_rx_ring.h"
+
+#include "pico/stdlib.h"
+#include "hardware/uart.h"
+#include "hardware/dma.h"
+
+// UART Configuration
+#define UART_ID uart0
+#define UART_TX_PIN 0
+#define UART_RX_PIN 1
+
+static link_encoder_t encoder;
+static link_decoder_t decoder;
+static link_frame_handler_t frame_handler = NULL;
+static void *frame_handler_ctx = NULL;
+static link_baud_master_t baud_master;
+static link_uart_errors_t errors = {0};
+
+// Frames go out by DMA from two staging buffers: one on the wire, the other
+// collecting the frames sent meanwhile. Sending costs the encode and a DMA
+// start; nothing waits on the UART unless both buffers are in use.
+#define TX_BUFFER_SIZE (2 * LINK_MAX_ENCODED)
+
+static uint8_t tx_buffers[2][TX_BUFFER_SIZE];
+static uint8_t tx_next = 0;    // Buffer collecting frames
+static size_t tx_fill = 0;     // Bytes queued in it
+static int tx_dma_chan = -1;
+
+// Start the collected frames if the wire is free
+static void tx_kick(void)
+{
+    if (tx_fill == 0 || dma_channel_is_busy(tx_dma_chan)) {
+        return;
+    }
+    dma_channel_transfer_from_buffer_now(tx_dma_chan, tx_buffers[tx_next], tx_fill);
+    tx_next ^= 1;
+    tx_fill = 0;
+}
+
+// Wait until everything queued has left the UART
+static void tx_flush(void)
+{
+    while (tx_fill > 0 || dma_channel_is_busy(tx_dma_chan)) {
+        tx_kick();
+    }
+    uart_tx_wait_blocking(UART_ID);
+}
+
+static uint32_t now_ms(void)
+{
+    return to_ms_since_boot(get_absolute_time());
+}
+
+static void link_set_baud(void *ctx, uint32_t baud)
+{
+    (void)ctx;
+    tx_flush();
+    uart_set_baudrate(UART_ID, baud);
+}
+
+static void link_send(void *ctx, uint8_t type, const uint8_t *payload, size_t len)
+{
+    (void)ctx;
+    link_uart_send(type, payload, len);
+}
+
+static void handle_frame(const link_frame_t *frame, void *ctx)
+{
+    (void)ctx;
+    if (!link_baud_master_handle_frame(&baud_master, frame, now_ms()) && frame_handler) {
+        frame_handler(frame, frame_handler_ctx);
+    }
+}
+
+void link_uart_init(void)
+{
+    // Initialize UART to Switch Pico
+    uart_init(UART_ID, LINK_BAUD_BASE);
+    gpio_set_function(UART_TX_PIN, GPIO_FUNC_UART);
+    gpio_set_function(UART_RX_PIN, GPIO_FUNC_UART);
+    uart_set_fifo_enabled(UART_ID, true);
+
+    tx_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config cfg = dma_channel_get_default_config(tx_dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, uart_get_dreq(UART_ID, true));
+    dma_channel_configure(tx_dma_chan, &cfg, &uart_get_hw(UART_ID)->dr, tx_buffers[0], 0, false);
+
+    // The RX DMA keeps running across baud changes
+    link_rx_ring_init(uart_get_dreq(UART_ID, false), &uart_get_hw(UART_ID)->dr);
+
+    link_encoder_init(&encoder);
+    link_decoder_init(&decoder);
+
+    const link_baud_ops_t baud_ops = {
+        .set_baud = link_set_baud,
+        .send = link_send,
+        .ctx = NULL,
+    };
+    link_baud_master_init(&baud_master, &baud_ops, now_ms());
+}
+
+void link_uart_set_frame_handler(link_frame_handler_t handler, void *ctx)
+{
+    frame_handler = handler;
+    frame_handler_ctx = ctx;
+}
+
+uint8_t link_uart_send(uint8_t type, const uint8_t *payload, size_t len)
+{
+    uint8_t seq = encoder.seq;
+
+    // Anything collected is already queued behind a busy DMA, so when this
+    // frame doesn't fit, the wire frees up before the collecting buffer does
+    if (tx_fill + LINK_ENCODED_SIZE(len) > TX_BUFFER_SIZE) {
+        dma_channel_wait_for_finish_blocking(tx_dma_chan);
+        tx_kick();
+    }
+    tx_fill += link_encode(&encoder, type, payload, len, &tx_buffers[tx_next][tx_fill]);
+    tx_kick();
+    return seq;
+}
+
+bool link_uart_can_send(void)
+{
+    tx_kick();
+    return tx_fill == 0;
+}
+
+void link_uart_task(void)
+{
+    const uint8_t *chunk;
+    size_t chunk_len;
+
+    tx_kick();
+
+    // Sticky overrun flag: the FIFO filled before DMA could drain it
+    uart_hw_t *hw = uart_get_hw(UART_ID);
+    if (hw->rsr & UART_UARTRSR_OE_BITS) {
+        hw->rsr = UART_UARTRSR_OE_BITS;
+        errors.rx_overruns++;
+    }
+
+    while ((chunk_len = link_rx_ring_peek(&chunk)) > 0) {
+        link_decoder_feed(&decoder, chunk, chunk_len, handle_frame, NULL);
+        link_rx_ring_consume(chunk_len);
+    }
+
+    link_baud_master_poll(&baud_master, now_ms(), &decoder.stats);
+}
+
+uint32_t link_uart_get_baud(void)
+{
+    return baud_master.baud;
+}
+
+void link_uart_get_stats(link_rx_stats_t *stats)
+{
+    *stats = decoder.stats;
+}
+
+void link_uart_get_errors(link_uart_errors_t *out)
+{
+    link_rx_ring_stats_t ring;
+    link_rx_ring_get_stats(&ring);
+
+    *out = errors;
+    out->ring_overflows = ring.ring_overflows;
+}
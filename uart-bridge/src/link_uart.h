@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "link_protocol.h"
+
+// Link to the Switch Pico (bridge side)
+//
+// Frames every message sent to the Switch Pico and reads its replies; call
+// link_uart_task() from the main loop. Two implementations, selected with
+// LINK_TRANSPORT at configure time (must match the Switch Pico build):
+//   link_uart.c     - UART on GP0/GP1. Starts at LINK_BAUD_BASE and is
+//                     negotiated up to the fastest rate that passes the
+//                     probe (see common/link_baud.h).
+//   link_uart_pio.c - clocked synchronous link (common/link_sync.pio)
+
+void link_uart_init(void);
+
+// Encode one frame for the Switch Pico and start sending it by DMA; returns
+// the sequence number it was sent with
+uint8_t link_uart_send(uint8_t type, const uint8_t *payload, size_t len);
+
+// True when a frame sent now would at most wait for the one already on the
+// wire. Senders that can replace a waiting frame by a newer one hold it back
+// until then, so the queue never grows under load.
+bool link_uart_can_send(void);
+
+// Handler for frames from the Switch Pico (acks); link-management frames
+// are consumed internally and never reach it
+void link_uart_set_frame_handler(link_frame_handler_t handler, void *ctx);
+
+// Drain replies from the Switch Pico and advance the baud negotiation
+void link_uart_task(void);
+
+// Current link rate in bit/s
+uint32_t link_uart_get_baud(void);
+
+// Receive counters for frames coming back from the Switch Pico
+void link_uart_get_stats(link_rx_stats_t *stats);
+
+typedef struct {
+    uint32_t rx_overruns;     // Receiver FIFO overruns (UART OE, PIO RX stall)
+    uint32_t ring_overflows;  // DMA receive ring lapped
+} link_uart_errors_t;
+
+// Receiver errors on the link from the Switch Pico
+void link_uart_get_errors(link_uart_errors_t *errors);
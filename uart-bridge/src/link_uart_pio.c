@@ -0,0 +1,119 @@
+// Clocked synchronous link to the Switch Pico driven by PIO and DMA
+//
+// Same programs and wiring as the Switch Pico side (common/link_sync.pio).
+// Encoded frames are handed to a DMA channel and replies land in the DMA
+// ring from common/link_rx_ring.c, so forwarding costs one memcpy per frame.
+// The bit rate is fixed; there is nothing to negotiate.
+
+#include "link_uart.h"
+#include "link_rx_ring.h"
+#include "link_sync.pio.h"
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+
+#define LINK_PIO pio1
+
+static link_encoder_t encoder;
+static link_decoder_t decoder;
+static link_frame_handler_t frame_handler = NULL;
+static void *frame_handler_ctx = NULL;
+static uint tx_sm;
+static uint rx_sm;
+static int tx_dma_chan = -1;
+static uint8_t tx_buffer[LINK_MAX_ENCODED];
+static link_uart_errors_t errors = {0};
+
+static void handle_frame(const link_frame_t *frame, void *ctx)
+{
+    (void)ctx;
+    if (frame_handler) {
+        frame_handler(frame, frame_handler_ctx);
+    }
+}
+
+void link_uart_init(void)
+{
+    tx_sm = (uint)pio_claim_unused_sm(LINK_PIO, true);
+    rx_sm = (uint)pio_claim_unused_sm(LINK_PIO, true);
+
+    uint tx_offset = pio_add_program(LINK_PIO, &link_sync_tx_program);
+    uint rx_offset = pio_add_program(LINK_PIO, &link_sync_rx_program);
+    link_sync_tx_program_init(LINK_PIO, tx_sm, tx_offset, LINK_SYNC_TX_PIN, LINK_SYNC_BIT_RATE);
+    link_sync_rx_program_init(LINK_PIO, rx_sm, rx_offset, LINK_SYNC_RX_PIN);
+
+    // Byte-wide writes to the TX FIFO are replicated across the word, which
+    // puts each byte where the program shifts from (bits 31..24)
+    tx_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config cfg = dma_channel_get_default_config(tx_dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, pio_get_dreq(LINK_PIO, tx_sm, true));
+    dma_channel_configure(tx_dma_chan, &cfg, &LINK_PIO->txf[tx_sm], tx_buffer, 0, false);
+
+    link_rx_ring_init(pio_get_dreq(LINK_PIO, rx_sm, false), &LINK_PIO->rxf[rx_sm]);
+
+    link_encoder_init(&encoder);
+    link_decoder_init(&decoder);
+}
+
+void link_uart_set_frame_handler(link_frame_handler_t handler, void *ctx)
+{
+    frame_handler = handler;
+    frame_handler_ctx = ctx;
+}
+
+uint8_t link_uart_send(uint8_t type, const uint8_t *payload, size_t len)
+{
+    uint8_t seq = encoder.seq;
+    // The previous frame may still be going out of the buffer
+    dma_channel_wait_for_finish_blocking(tx_dma_chan);
+    size_t packet_len = link_encode(&encoder, type, payload, len, tx_buffer);
+    dma_channel_transfer_from_buffer_now(tx_dma_chan, tx_buffer, packet_len);
+    return seq;
+}
+
+bool link_uart_can_send(void)
+{
+    // One buffer: a send while it is going out blocks until it is done
+    return !dma_channel_is_busy(tx_dma_chan);
+}
+
+void link_uart_task(void)
+{
+    const uint8_t *chunk;
+    size_t chunk_len;
+
+    // Sticky stall flag: the RX FIFO was full when a byte completed
+    uint32_t rx_stall = 1u << (PIO_FDEBUG_RXSTALL_LSB + rx_sm);
+    if (LINK_PIO->fdebug & rx_stall) {
+        LINK_PIO->fdebug = rx_stall;
+        errors.rx_overruns++;
+    }
+
+    while ((chunk_len = link_rx_ring_peek(&chunk)) > 0) {
+        link_decoder_feed(&decoder, chunk, chunk_len, handle_frame, NULL);
+        link_rx_ring_consume(chunk_len);
+    }
+}
+
+uint32_t link_uart_get_baud(void)
+{
+    return LINK_SYNC_BIT_RATE;
+}
+
+void link_uart_get_stats(link_rx_stats_t *stats)
+{
+    *stats = decoder.stats;
+}
+
+void link_uart_get_errors(link_uart_errors_t *out)
+{
+    link_rx_ring_stats_t ring;
+    link_rx_ring_get_stats(&ring);
+
+    *out = errors;
+    out->ring_overflows = ring.ring_overflows;
+}
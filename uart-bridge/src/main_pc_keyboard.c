@@ -1,6 +1,8 @@
 // UART Bridge for Nintendo Switch Controller - PC Keyboard Version
 // This Pico receives binary controller packets from PC via USB serial
-// and forwards them to the Switch Pico via UART
+// and forwards them to the Switch Pico via UART. Acks and console output
+// reports (rumble, LEDs) coming back from the Switch Pico are relayed to
+// the PC.
 //
 // Connect: This Pico GP0 (TX) -> Switch Pico GP1 (RX)
 //          This Pico GP1 (RX) -> Switch Pico GP0 (TX)
@@ -9,114 +11,326 @@
 
 #include "pico/stdlib.h"
 #include "hardware/uart.h"
-#include <stdio.h>
+#include "link_protocol.h"
+#include "link_uart.h"
+#include "link_stats.h"
+#include "pc_serial.h"
 #include <string.h>
 
-// UART Configuration
-#define UART_ID uart0
-#define UART_TX_PIN 0
-#define UART_RX_PIN 1
-#define UART_BAUD_RATE 115200
-
-// Controller state packet (matches Python script)
-typedef struct __attribute__((packed)) {
-    uint16_t buttons;    // Button bitmask
-    uint8_t  hat;        // D-Pad/HAT value
-    uint8_t  lx;         // Left stick X (0-255)
-    uint8_t  ly;         // Left stick Y (0-255)
-    uint8_t  rx;         // Right stick X (0-255)
-    uint8_t  ry;         // Right stick Y (0-255)
-    uint8_t  vendor;     // Vendor byte (unused)
-} controller_state_t;
-
-#define PACKET_SIZE sizeof(controller_state_t)
+// Debug text on the USB serial, off by default: at 1 kHz a line per frame
+// is far more than the frames themselves. Enable with -DBRIDGE_VERBOSE=ON.
+#ifndef BRIDGE_VERBOSE
+#define BRIDGE_VERBOSE 0
+#endif
+
+#define LOG(...) do { if (BRIDGE_VERBOSE) pc_serial_printf(__VA_ARGS__); } while (0)
+
+// Newest state of a controller waiting for the link
+typedef struct {
+    bool valid;
+    bool keyframe;                // The PC sent a keyframe since the last send
+    uint8_t state[LINK_STATE_SIZE];
+    uint8_t pc_seq;               // Newest PC frame folded in, and when it was read
+    uint32_t rx_us;
+} pending_state_t;
+
+typedef struct {
+    uint32_t packets_forwarded;
+    uint32_t acks_relayed;
+    uint32_t led_toggle_time;
+    uint8_t pc_seq[256];          // PC sequence number, indexed by UART-hop seq
+    link_encoder_t pc_encoder;    // Frames sent back to the PC
+    const link_rx_stats_t *pc_stats;
+    // Per virtual controller
+    link_delta_t pc_delta[LINK_MAX_CONTROLLERS];   // State as received from the PC
+    link_delta_t hop_delta[LINK_MAX_CONTROLLERS];  // State as sent to the Switch Pico
+    pending_state_t pending[LINK_MAX_CONTROLLERS];
+    uint8_t next_pending;         // Controller whose waiting state goes first
+    // Counters answered on a LINK_TYPE_STATS query (see link_stats.h)
+    link_stats_t perf;
+    uint32_t rx_us;               // When the chunk that completed the frame was read
+} bridge_ctx_t;
+
+static void write_pc_frame(bridge_ctx_t *bridge, uint8_t type, const uint8_t *payload, size_t len);
+
+// Answer a counter query addressed to this Pico
+static void send_stats(bridge_ctx_t *bridge)
+{
+    link_stats_t stats = bridge->perf;
+    link_uart_errors_t errors;
+    uint8_t reply[LINK_STATS_REPLY_SIZE];
+
+    link_uart_get_errors(&errors);
+    stats.uptime_ms = to_ms_since_boot(get_absolute_time());
+    stats.frames_ok = bridge->pc_stats->frames_ok;
+    stats.frames_lost = bridge->pc_stats->frames_lost;
+    stats.crc_errors = bridge->pc_stats->crc_errors;
+    stats.resyncs = bridge->pc_stats->resyncs;
+    stats.rx_overruns = errors.rx_overruns;
+    stats.ring_overflows = errors.ring_overflows;
+    stats.reports_sent = bridge->packets_forwarded;
+
+    link_stats_pack(LINK_STATS_BRIDGE, &stats, reply);
+    write_pc_frame(bridge, LINK_TYPE_STATS, reply, sizeof(reply));
+}
+
+static void note_forwarded(bridge_ctx_t *bridge, uint8_t hop_seq, uint8_t pc_seq, uint32_t rx_us)
+{
+    bridge->pc_seq[hop_seq] = pc_seq;
+    bridge->packets_forwarded++;
+    link_stats_hist_add(bridge->perf.latency_hist, &bridge->perf.latency_max_us,
+                        time_us_32() - rx_us);
+
+    // Blink LED on activity
+    gpio_put(PICO_DEFAULT_LED_PIN, 1);
+    bridge->led_toggle_time = to_ms_since_boot(get_absolute_time()) + 50;
+}
+
+// Link state bytes with nothing pressed: buttons, hat released, sticks centred
+static const uint8_t neutral_state[LINK_STATE_SIZE] = {
+    0x00, 0x00, 0x08, 0x80, 0x80, 0x80, 0x80, 0x00
+};
+
+// Fold the newest state into one still waiting for the link: take the newest
+// state, except for buttons and the D-pad whose change since the last sent
+// state hasn't gone out yet. Those keep their waiting value, so a press and
+// release closer together than the link can carry still reach the Switch
+// Pico as two states.
+static void merge_state(uint8_t *waiting, const uint8_t *sent, const uint8_t *latest)
+{
+    uint16_t held = (uint16_t)(waiting[0] | (waiting[1] << 8));
+    uint16_t unsent = held ^ (uint16_t)(sent[0] | (sent[1] << 8));
+    uint16_t buttons = (uint16_t)((latest[0] | (latest[1] << 8)) & ~unsent) | (held & unsent);
+    uint8_t hat = waiting[2] != sent[2] ? waiting[2] : latest[2];
+
+    memcpy(waiting, latest, LINK_STATE_SIZE);
+    waiting[0] = (uint8_t)(buttons & 0xFF);
+    waiting[1] = (uint8_t)(buttons >> 8);
+    waiting[2] = hat;
+}
+
+// Send a controller's waiting state if the link can take it without queueing
+// behind more than the frame already on the wire
+static bool send_pending(bridge_ctx_t *bridge, uint8_t id)
+{
+    pending_state_t *pending = &bridge->pending[id];
+
+    if (!pending->valid || !link_uart_can_send()) {
+        return false;
+    }
+    if (pending->keyframe) {
+        link_delta_reset(&bridge->hop_delta[id]);
+        pending->keyframe = false;
+    }
+
+    uint8_t type;
+    uint8_t payload[LINK_DELTA_MAX_SIZE];
+    size_t len = link_delta_encode(&bridge->hop_delta[id], pending->state, &type, payload);
+    note_forwarded(bridge, link_uart_send(type, payload, len), pending->pc_seq, pending->rx_us);
+
+    // Held-back edges went out; the newest state follows next
+    const uint8_t *latest = bridge->pc_delta[id].state;
+    pending->valid = memcmp(pending->state, latest, LINK_STATE_SIZE) != 0;
+    memcpy(pending->state, latest, LINK_STATE_SIZE);
+    return true;
+}
+
+// Give every controller's waiting state a turn at the link
+static void flush_pending(bridge_ctx_t *bridge)
+{
+    for (int i = 0; i < LINK_MAX_CONTROLLERS; i++) {
+        uint8_t id = (uint8_t)((bridge->next_pending + i) % LINK_MAX_CONTROLLERS);
+        if (send_pending(bridge, id)) {
+            bridge->next_pending = (uint8_t)((id + 1) % LINK_MAX_CONTROLLERS);
+        }
+    }
+}
+
+// Called for every frame from the PC that passed its CRC check. The frame is
+// re-encoded for the UART hop: this Pico also originates baud negotiation
+// frames, so sequence numbers on each hop come from that hop's sender.
+//
+// Delta frames only make sense against the previous state on the same hop,
+// so states are decoded here and delta-encoded again for the UART. A PC
+// keyframe is passed on as a keyframe; deltas that arrive after a lost frame
+// are dropped until the next one. Each virtual controller is tracked on its
+// own.
+//
+// When the PC sends states faster than the UART drains them, only the newest
+// state per controller waits for the link (see merge_state), so queueing
+// stays bounded at one frame instead of growing with the backlog.
+static void forward_frame(const link_frame_t *frame, void *ctx)
+{
+    bridge_ctx_t *bridge = (bridge_ctx_t *)ctx;
+
+    // Counter queries for the Switch Pico go through like any other frame
+    if (frame->type == LINK_TYPE_STATS && frame->len >= 1 && frame->payload[0] == LINK_STATS_BRIDGE) {
+        send_stats(bridge);
+        return;
+    }
+
+    if (frame->type == LINK_TYPE_STATE || frame->type == LINK_TYPE_DELTA) {
+        uint8_t id = link_state_controller(frame);
+        if (id >= LINK_MAX_CONTROLLERS ||
+            !link_delta_decode(&bridge->pc_delta[id], frame, bridge->pc_stats)) {
+            return;
+        }
+
+        pending_state_t *pending = &bridge->pending[id];
+        const uint8_t *p = bridge->pc_delta[id].state;
+        if (pending->valid) {
+            merge_state(pending->state, bridge->hop_delta[id].state, p);
+            bridge->perf.frames_coalesced++;
+        } else {
+            memcpy(pending->state, p, LINK_STATE_SIZE);
+            pending->valid = true;
+        }
+        pending->keyframe |= frame->type == LINK_TYPE_STATE;
+        pending->pc_seq = frame->seq;
+        pending->rx_us = bridge->rx_us;
+        send_pending(bridge, id);
+
+        LOG("[RX] P%d Buttons=0x%04X HAT=%d LX=%d LY=%d RX=%d RY=%d\r\n",
+            id + 1, p[0] | (p[1] << 8), p[2], p[3], p[4], p[5], p[6]);
+    } else {
+        note_forwarded(bridge, link_uart_send(frame->type, frame->payload, frame->len),
+                       frame->seq, bridge->rx_us);
+    }
+}
+
+static void write_pc_frame(bridge_ctx_t *bridge, uint8_t type, const uint8_t *payload, size_t len)
+{
+    uint8_t packet[1 + LINK_MAX_ENCODED];
+
+    // Verbose builds mix debug text into the USB serial: a leading delimiter
+    // ends any text the PC has buffered so the frame decodes on its own
+    packet[0] = LINK_DELIMITER;
+    size_t packet_len = link_encode(&bridge->pc_encoder, type, payload, len, &packet[1]);
+    pc_serial_write(packet, 1 + packet_len);
+}
+
+// Called for frames from the Switch Pico. Acks name the UART-hop sequence
+// number; translate it back to the PC's before relaying. Clock sync, macro
+// upload and counter replies and console output reports go through
+// unchanged.
+static void relay_frame(const link_frame_t *frame, void *ctx)
+{
+    bridge_ctx_t *bridge = (bridge_ctx_t *)ctx;
+    link_ack_t ack;
+
+    switch (frame->type) {
+        case LINK_TYPE_ACK:
+            if (!link_ack_unpack(frame->payload, frame->len, &ack)) {
+                break;
+            }
+            ack.seq = bridge->pc_seq[ack.seq];
+
+            uint8_t payload[LINK_ACK_SIZE];
+            link_ack_pack(&ack, payload);
+            write_pc_frame(bridge, LINK_TYPE_ACK, payload, sizeof(payload));
+            bridge->acks_relayed++;
+            break;
+
+        case LINK_TYPE_TIME:
+        case LINK_TYPE_MACRO:
+        case LINK_TYPE_OUTPUT:
+        case LINK_TYPE_STATS:
+            write_pc_frame(bridge, frame->type, frame->payload, frame->len);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void print_banner(void)
+{
+    LOG("\r\n");
+    LOG("Nintendo Switch UART Bridge - PC Keyboard Mode\r\n");
+    LOG("  This Pico GP0 (TX) -> simple-s2rc Pico GP1 (RX)\r\n");
+    LOG("  This Pico GP1 (RX) -> simple-s2rc Pico GP0 (TX)\r\n");
+    LOG("  GND -> GND, this Pico USB -> PC\r\n");
+    LOG("Link @ %lu bit/s, protocol v%d\r\n\r\n", (unsigned long)link_uart_get_baud(),
+        LINK_PROTOCOL_VERSION);
+}
 
 int main(void)
 {
-    // Initialize stdio for USB serial
-    stdio_init_all();
-    
     // Initialize LED
     gpio_init(PICO_DEFAULT_LED_PIN);
     gpio_set_dir(PICO_DEFAULT_LED_PIN, GPIO_OUT);
     
-    // Initialize UART to Switch Pico
-    uart_init(UART_ID, UART_BAUD_RATE);
-    gpio_set_function(UART_TX_PIN, GPIO_FUNC_UART);
-    gpio_set_function(UART_RX_PIN, GPIO_FUNC_UART);
-    uart_set_fifo_enabled(UART_ID, true);
+    // USB serial to the PC
+    pc_serial_init();
     
-    sleep_ms(2000);  // Wait for USB serial to be ready
+    // Initialize the link to Switch Pico (a UART link negotiates a faster
+    // rate in the background)
+    link_uart_init();
     
-    printf("\n");
-    printf("═══════════════════════════════════════════════════════\n");
-    printf("  Nintendo Switch UART Bridge - PC Keyboard Mode\n");
-    printf("═══════════════════════════════════════════════════════\n");
-    printf("\n");
-    printf("Hardware Connections:\n");
-    printf("  This Pico GP0 (TX) -> simple-s2rc Pico GP1 (RX)\n");
-    printf("  This Pico GP1 (RX) -> simple-s2rc Pico GP0 (TX)\n");
-    printf("  GND -> GND\n");
-    printf("  This Pico USB -> PC\n");
-    printf("\n");
-    printf("UART initialized @ %d baud\n", UART_BAUD_RATE);
-    printf("\n");
-    printf("Ready to receive binary packets from PC!\n");
-    printf("Run: python keyboard_to_serial.py COM<X>\n");
-    printf("\n");
-    printf("═══════════════════════════════════════════════════════\n");
-    printf("\n");
+    static bridge_ctx_t bridge = {0};
+    link_encoder_init(&bridge.pc_encoder);
+    link_uart_set_frame_handler(relay_frame, &bridge);
     
-    uint8_t packet_buffer[PACKET_SIZE];
-    uint8_t packet_index = 0;
-    uint32_t packets_received = 0;
-    uint32_t packets_forwarded = 0;
+    static link_decoder_t decoder;
+    link_decoder_init(&decoder);
+    bridge.pc_stats = &decoder.stats;
+    for (int i = 0; i < LINK_MAX_CONTROLLERS; i++) {
+        link_delta_init(&bridge.pc_delta[i], 0);
+        link_delta_init(&bridge.hop_delta[i], 0);  // Keyframes follow the PC's
+        bridge.hop_delta[i].controller = (uint8_t)i;
+        // merge_state() compares against this before the first send: all
+        // zeros would read as the D-pad held up
+        memcpy(bridge.hop_delta[i].state, neutral_state, LINK_STATE_SIZE);
+    }
     uint32_t last_stats_time = 0;
-    bool led_state = false;
-    uint32_t led_toggle_time = 0;
+    uint32_t last_loop_us = time_us_32();
+    bool connected = false;
     
     while (true) {
-        // Read bytes from USB serial
-        int c = getchar_timeout_us(0);
+        uint32_t loop_us = time_us_32();
+        link_stats_hist_add(bridge.perf.loop_hist, &bridge.perf.loop_max_us, loop_us - last_loop_us);
+        last_loop_us = loop_us;
+
+        pc_serial_task();
+
+        // Everything the PC sent since the last pass, in one read
+        uint8_t buffer[256];  // CFG_TUD_CDC_RX_BUFSIZE
+        size_t count = pc_serial_read(buffer, sizeof(buffer));
+        if (count > 0) {
+            bridge.rx_us = time_us_32();
+            link_decoder_feed(&decoder, buffer, count, forward_frame, &bridge);
+        }
+        
+        // Replies from the Switch Pico, baud negotiation and keepalives
+        link_uart_task();
+        
+        // States held back while the link was busy
+        flush_pending(&bridge);
         
-        if (c != PICO_ERROR_TIMEOUT) {
-            packet_buffer[packet_index++] = (uint8_t)c;
-            
-            // When we have a complete packet
-            if (packet_index >= PACKET_SIZE) {
-                // Forward the packet to Switch Pico via UART
-                uart_write_blocking(UART_ID, packet_buffer, PACKET_SIZE);
-                
-                packets_received++;
-                packets_forwarded++;
-                
-                // Blink LED on activity
-                gpio_put(PICO_DEFAULT_LED_PIN, 1);
-                led_toggle_time = to_ms_since_boot(get_absolute_time()) + 50;
-                
-                // Parse and display state for debugging
-                controller_state_t *state = (controller_state_t*)packet_buffer;
-                printf("[RX] Buttons=0x%04X HAT=%d LX=%d LY=%d RX=%d RY=%d\n",
-                       state->buttons, state->hat, state->lx, state->ly, 
-                       state->rx, state->ry);
-                
-                // Reset for next packet
-                packet_index = 0;
+        // Greet a terminal when it opens the port (verbose builds)
+        if (pc_serial_connected() != connected) {
+            connected = !connected;
+            if (connected) {
+                print_banner();
             }
         }
         
         // Turn off LED after activity
         uint32_t now = to_ms_since_boot(get_absolute_time());
-        if (led_toggle_time > 0 && now >= led_toggle_time) {
+        if (bridge.led_toggle_time > 0 && now >= bridge.led_toggle_time) {
             gpio_put(PICO_DEFAULT_LED_PIN, 0);
-            led_toggle_time = 0;
+            bridge.led_toggle_time = 0;
         }
         
-        // Print stats every 10 seconds
+        // Print stats every 10 seconds (verbose builds; see --stats otherwise)
         if (now - last_stats_time >= 10000) {
-            if (packets_received > 0) {
-                printf("\n[STATS] Packets: RX=%lu, FWD=%lu\n\n", 
-                       packets_received, packets_forwarded);
+            if (decoder.stats.frames_ok > 0) {
+                LOG("\r\n[STATS] Packets: RX=%lu, FWD=%lu, lost=%lu, CRC errors=%lu, resyncs=%lu\r\n",
+                    (unsigned long)decoder.stats.frames_ok, (unsigned long)bridge.packets_forwarded,
+                    (unsigned long)decoder.stats.frames_lost, (unsigned long)decoder.stats.crc_errors,
+                    (unsigned long)decoder.stats.resyncs);
+                LOG("[STATS] Link: %lu baud, acks relayed=%lu\r\n\r\n",
+                    (unsigned long)link_uart_get_baud(), (unsigned long)bridge.acks_relayed);
             }
             last_stats_time = now;
         }
@@ -0,0 +1,59 @@
+// USB CDC serial to the PC, driven directly through TinyUSB
+
+#include "pc_serial.h"
+
+#include "tusb.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+void pc_serial_init(void)
+{
+    tusb_init();
+}
+
+void pc_serial_task(void)
+{
+    tud_task();
+}
+
+bool pc_serial_connected(void)
+{
+    return tud_cdc_connected();
+}
+
+size_t pc_serial_read(uint8_t *data, size_t size)
+{
+    if (!tud_cdc_available()) {
+        return 0;
+    }
+    return tud_cdc_read(data, (uint32_t)size);
+}
+
+bool pc_serial_write(const uint8_t *data, size_t len)
+{
+    // A partial frame would only cost the PC a resync, but a partial write
+    // followed by the rest of a later one corrupts two
+    if (!tud_cdc_connected() || tud_cdc_write_available() < len) {
+        return false;
+    }
+    tud_cdc_write(data, (uint32_t)len);
+    tud_cdc_write_flush();
+    return true;
+}
+
+void pc_serial_printf(const char *format, ...)
+{
+    char text[160];
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    if (len > 0) {
+        if ((size_t)len >= sizeof(text)) {
+            len = sizeof(text) - 1;
+        }
+        pc_serial_write((const uint8_t *)text, (size_t)len);
+    }
+}
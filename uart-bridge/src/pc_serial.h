@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// USB CDC serial to the PC (bridge side)
+//
+// The bridge runs TinyUSB itself rather than through pico_stdio_usb: frames
+// from the PC are read in bulk straight out of the CDC FIFO, and nothing
+// blocks on a full endpoint. Call pc_serial_task() from the main loop.
+
+void pc_serial_init(void);
+
+// Service USB (tud_task)
+void pc_serial_task(void);
+
+// True while a program on the PC has the port open
+bool pc_serial_connected(void);
+
+// Copy up to size bytes received from the PC; returns the count
+size_t pc_serial_read(uint8_t *data, size_t size);
+
+// Queue len bytes for the PC, all or nothing: returns false (and drops
+// them) if the port is closed or the CDC FIFO has no room
+bool pc_serial_write(const uint8_t *data, size_t len);
+
+// Debug text for verbose builds; dropped like pc_serial_write()
+void pc_serial_printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
@@ -22,6 +22,33 @@ extern "C" {
 #define CFG_TUSB_DEBUG        0
 #endif
 
+#ifdef BRIDGE_USB_HOST
+
+// Enable Host mode (main.c: keyboards and gamepads plugged into the bridge)
+#define CFG_TUH_ENABLED       1
+
+// RHPORT0 is the USB controller on the Pico
+// In the USB host build it runs in HOST mode, behind an OTG adapter
+#define CFG_TUSB_RHPORT0_MODE   OPT_MODE_HOST
+
+//--------------------------------------------------------------------
+// HOST CONFIGURATION
+//--------------------------------------------------------------------
+
+// Room for the report descriptors of gaming keyboards and pads
+#define CFG_TUH_ENUMERATION_BUFSIZE 512
+
+// One hub, so several devices can be plugged in at once
+#define CFG_TUH_HUB               1
+#define CFG_TUH_DEVICE_MAX        (CFG_TUH_HUB ? 4 : 1)
+
+// HID interfaces in total (a keyboard often has two); see HID_INPUT_MAX_DEVICES
+#define CFG_TUH_HID               8
+#define CFG_TUH_HID_EPIN_BUFSIZE  64
+#define CFG_TUH_HID_EPOUT_BUFSIZE 64
+
+#else
+
 // Enable Device mode
 #define CFG_TUD_ENABLED       1
 
@@ -46,7 +73,9 @@ extern "C" {
 
 // CDC FIFO size of TX and RX
 #define CFG_TUD_CDC_RX_BUFSIZE   256
-#define CFG_TUD_CDC_TX_BUFSIZE   256
+#define CFG_TUD_CDC_TX_BUFSIZE   512  // Room for a counters reply next to acks
+
+#endif // BRIDGE_USB_HOST
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,100 @@
+#include "tusb.h"
+#include "pico/unique_id.h"
+#include <string.h>
+
+/* ================= Device Descriptor ================= */
+/* Same IDs as pico_stdio_usb, so the PC finds the same serial port */
+
+tusb_desc_device_t const desc_device = {
+    .bLength            = sizeof(tusb_desc_device_t),
+    .bDescriptorType    = TUSB_DESC_DEVICE,
+    .bcdUSB             = 0x0200,
+
+    // IAD: CDC uses two interfaces
+    .bDeviceClass       = TUSB_CLASS_MISC,
+    .bDeviceSubClass    = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol    = MISC_PROTOCOL_IAD,
+
+    .bMaxPacketSize0    = CFG_TUD_ENDPOINT0_SIZE,
+
+    .idVendor           = 0x2E8A, // Raspberry Pi
+    .idProduct          = 0x000A, // Pico SDK CDC
+    .bcdDevice          = 0x0100,
+
+    .iManufacturer      = 0x01,
+    .iProduct           = 0x02,
+    .iSerialNumber      = 0x03,
+
+    .bNumConfigurations = 0x01
+};
+
+uint8_t const * tud_descriptor_device_cb(void)
+{
+    return (uint8_t const *) &desc_device;
+}
+
+/* ================= Configuration Descriptor ================= */
+
+#define ITF_NUM_CDC      0
+#define ITF_NUM_CDC_DATA 1
+#define ITF_NUM_TOTAL    2
+
+#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN)
+
+uint8_t const desc_configuration[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 100),
+
+    // Notification endpoint 0x81, data OUT 0x02 / IN 0x82
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 4, 0x81, 8, 0x02, 0x82, 64),
+};
+
+uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
+{
+    (void) index;
+    return desc_configuration;
+}
+
+/* ================= String Descriptors ================= */
+
+static const char *string_desc_arr[] = {
+    (const char[]){0x09, 0x04}, // English
+    "Raspberry Pi",
+    "Pico",
+    NULL,                       // Serial: the flash unique ID
+    "Board CDC",
+};
+
+static uint16_t _desc_str[32];
+
+uint16_t const* tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+    (void) langid;
+
+    char serial[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+    uint8_t chr_count;
+
+    if (index == 0) {
+        memcpy(&_desc_str[1], string_desc_arr[0], 2);
+        chr_count = 1;
+    } else {
+        if (index >= sizeof(string_desc_arr) / sizeof(string_desc_arr[0])) {
+            return NULL;
+        }
+
+        const char* str = string_desc_arr[index];
+        if (str == NULL) {
+            pico_get_unique_board_id_string(serial, sizeof(serial));
+            str = serial;
+        }
+        chr_count = strlen(str);
+        if (chr_count > 31) {
+            chr_count = 31;
+        }
+        for (uint8_t i = 0; i < chr_count; i++) {
+            _desc_str[1 + i] = str[i];
+        }
+    }
+
+    _desc_str[0] = (TUSB_DESC_STRING << 8) | (2 * chr_count + 2);
+    return _desc_str;
+}